@@ -0,0 +1,158 @@
+#include "channel.h"
+#include "channeldata.h"
+#include "channelsmodel.h"
+#include "database.h"
+#include "programfactory.h"
+#include "programsmodel.h"
+#include "startup.h"
+
+#include <QAbstractItemModelTester>
+#include <QDir>
+#include <QStandardPaths>
+#include <QTest>
+
+// the models apply changes row by row (keeps the delegates), the signals must be consistent and the result must be the new content
+class ModelsTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void programsUpdate_data();
+    void programsUpdate();
+    void channelsReload();
+
+private:
+    static QVector<ProgramRowData> programs(const QStringList &rows); // "id start title" per row
+    static QStringList rows(const ProgramsModel &model);
+    static QVector<ChannelId> channelIds(const ChannelsModel &model);
+
+    const CountryId m_countryId = CountryId(QStringLiteral("test"));
+};
+
+void ModelsTest::initTestCase()
+{
+    QCoreApplication::setApplicationName(QStringLiteral("telly-skout-test"));
+    QStandardPaths::setTestModeEnabled(true);
+    QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).removeRecursively();
+    Startup::instance().openDatabase();
+    Database::instance().addCountry(m_countryId, QStringLiteral("Test"), QString());
+}
+
+QVector<ProgramRowData> ModelsTest::programs(const QStringList &rows)
+{
+    QVector<ProgramRowData> programs;
+    for (const QString &row : rows) {
+        const QStringList fields = row.split(QLatin1Char(' '));
+        ProgramRowData program;
+        program.m_id = ProgramId(fields.at(0));
+        program.m_start = fields.at(1).toLongLong();
+        program.m_stop = program.m_start + 10;
+        program.m_title = fields.at(2);
+        programs.append(program);
+    }
+    return programs;
+}
+
+QStringList ModelsTest::rows(const ProgramsModel &model)
+{
+    QStringList rows;
+    for (int row = 0; row < model.rowCount(QModelIndex()); ++row) {
+        const QModelIndex index = model.index(row, 0);
+        rows.append(model.data(index, ProgramsModel::IdRole).toString() + QLatin1Char(' ')
+                    + QString::number(model.data(index, ProgramsModel::StartRole).toLongLong() / 1000) + QLatin1Char(' ')
+                    + model.data(index, ProgramsModel::TitleRole).toString());
+    }
+    return rows;
+}
+
+QVector<ChannelId> ModelsTest::channelIds(const ChannelsModel &model)
+{
+    QVector<ChannelId> ids;
+    for (int row = 0; row < model.rowCount(QModelIndex()); ++row) {
+        const Channel *channel = model.data(model.index(row, 0), ChannelsModel::ChannelRole).value<Channel *>();
+        ids.append(ChannelId(channel->id()));
+    }
+    return ids;
+}
+
+void ModelsTest::programsUpdate_data()
+{
+    QTest::addColumn<QStringList>("before");
+    QTest::addColumn<QStringList>("after");
+
+    const QStringList abc = {QStringLiteral("a 0 A"), QStringLiteral("b 10 B"), QStringLiteral("c 20 C")};
+    QTest::newRow("unchanged") << abc << abc;
+    QTest::newRow("changed") << abc << QStringList{QStringLiteral("a 0 A"), QStringLiteral("b 10 B2"), QStringLiteral("c 20 C2")};
+    QTest::newRow("replaced at the same start") << abc << QStringList{QStringLiteral("a 0 A"), QStringLiteral("x 10 X"), QStringLiteral("c 20 C")};
+    QTest::newRow("removed at the end") << abc << QStringList{QStringLiteral("a 0 A"), QStringLiteral("b 10 B")};
+    QTest::newRow("removed in the middle") << abc << QStringList{QStringLiteral("a 0 A"), QStringLiteral("c 20 C")};
+    QTest::newRow("inserted before the first") << QStringList{QStringLiteral("b 10 B"), QStringLiteral("c 20 C")} << abc;
+    QTest::newRow("inserted at the end") << QStringList{QStringLiteral("a 0 A")} << abc;
+    QTest::newRow("split") << QStringList{QStringLiteral("a 0 A"), QStringLiteral("y 10 Y")} << abc;
+    QTest::newRow("merged") << abc << QStringList{QStringLiteral("a 0 A"), QStringLiteral("y 10 Y")};
+    QTest::newRow("moved window")
+        << abc << QStringList{QStringLiteral("b 10 B"), QStringLiteral("c 20 C"), QStringLiteral("d 30 D"), QStringLiteral("e 40 E")};
+    QTest::newRow("from empty") << QStringList() << abc;
+    QTest::newRow("to empty") << abc << QStringList();
+}
+
+void ModelsTest::programsUpdate()
+{
+    QFETCH(QStringList, before);
+    QFETCH(QStringList, after);
+
+    ChannelData data;
+    data.m_id = ChannelId(QStringLiteral("programs"));
+    ProgramFactory programFactory;
+    Channel channel(data, true, QVector<QString>(), programFactory);
+    ProgramsModel &model = *channel.programsModel();
+    QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::QtTest);
+
+    model.update(programs(before));
+    QCOMPARE(rows(model), before);
+
+    model.update(programs(after));
+    QCOMPARE(rows(model), after);
+}
+
+void ModelsTest::channelsReload()
+{
+    Database &database = Database::instance();
+    for (const QString &id : {QStringLiteral("a"), QStringLiteral("b"), QStringLiteral("c"), QStringLiteral("d")}) {
+        ChannelData data;
+        data.m_id = ChannelId(id);
+        data.m_name = id.toUpper();
+        database.addChannel(data, m_countryId);
+    }
+
+    ChannelsModel model; // only favorites
+    QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::QtTest);
+    QVERIFY(model.isLoaded());
+    QCOMPARE(channelIds(model), QVector<ChannelId>());
+
+    // every change of the favorites reloads the model
+    database.addFavorite(ChannelId(QStringLiteral("a")));
+    database.addFavorite(ChannelId(QStringLiteral("b")));
+    database.addFavorite(ChannelId(QStringLiteral("c")));
+    QCOMPARE(channelIds(model), database.favorites());
+    QCOMPARE(channelIds(model).size(), 3);
+
+    // reordered (moves only)
+    const QVector<ChannelId> reordered = {ChannelId(QStringLiteral("c")), ChannelId(QStringLiteral("a")), ChannelId(QStringLiteral("b"))};
+    database.sortFavorites(reordered);
+    QCOMPARE(channelIds(model), reordered);
+
+    // removed, inserted and moved at once
+    const QVector<ChannelId> replaced = {ChannelId(QStringLiteral("d")), ChannelId(QStringLiteral("b")), ChannelId(QStringLiteral("c"))};
+    database.sortFavorites(replaced);
+    QCOMPARE(channelIds(model), replaced);
+
+    database.removeFavorite(ChannelId(QStringLiteral("b")));
+    QCOMPARE(channelIds(model), database.favorites());
+    QCOMPARE(channelIds(model).size(), 2);
+}
+
+QTEST_GUILESS_MAIN(ModelsTest)
+
+#include "modelstest.moc"
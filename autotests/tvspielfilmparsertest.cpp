@@ -0,0 +1,162 @@
+#include "tvspielfilmparser.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRegularExpression>
+#include <QTest>
+
+// the parser searches the markers 8 bytes at once (SWAR), the results must not depend on where they are in the page
+class TvSpielfilmParserTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void rows_data();
+    void rows();
+    void lastRow_data();
+    void lastRow();
+    void pageCount();
+    void description();
+    void throughput();
+
+private:
+    static QByteArray readFixture(const QString &name);
+    static QStringList parseRows(const QByteArray &page); // one "start|stop|date|url|title|category" per row
+
+    QByteArray m_programPage;
+};
+
+QByteArray TvSpielfilmParserTest::readFixture(const QString &name)
+{
+    QFile file(QFINDTESTDATA(QStringLiteral("data/") + name));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+QStringList TvSpielfilmParserTest::parseRows(const QByteArray &page)
+{
+    QStringList rows;
+    TvSpielfilmParser parser(page);
+    TvSpielfilmParser::Row row;
+    while (parser.nextRow(row)) {
+        rows.append(QStringList{row.m_startTime.toString(),
+                                row.m_stopTime.toString(),
+                                row.m_date.toString(),
+                                row.m_descriptionUrl.toString(),
+                                row.m_title.toString(),
+                                row.m_category.toString()}
+                        .join(QLatin1Char('|')));
+    }
+    return rows;
+}
+
+void TvSpielfilmParserTest::initTestCase()
+{
+    m_programPage = readFixture(QStringLiteral("tvspielfilm-program.html"));
+    QVERIFY(!m_programPage.isEmpty());
+}
+
+void TvSpielfilmParserTest::rows_data()
+{
+    QTest::addColumn<int>("offset");
+
+    // every position of the markers in an 8 byte word (and the word before)
+    for (int offset = 0; offset < 16; ++offset) {
+        QTest::newRow(qPrintable(QString::number(offset))) << offset;
+    }
+}
+
+void TvSpielfilmParserTest::rows()
+{
+    QFETCH(int, offset);
+
+    // the row without a stop time is skipped
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression(QStringLiteral("^Failed to parse program row")));
+
+    const QStringList rows = parseRows(QByteArray(offset, ' ') + m_programPage);
+    QCOMPARE(rows.size(), 3);
+    QCOMPARE(rows.at(0),
+             QStringLiteral("05:30|09:00|09.11.|https://www.tvspielfilm.de/tv-programm/sendung/morgenmagazin,61876e2a8b25b1230cf7a2c1.html|Morgenmagazin|"
+                            "Nachrichten"));
+    QCOMPARE(rows.at(1),
+             QStringLiteral(
+                 "09:00|09:05|09.11.|https://www.tvspielfilm.de/tv-programm/sendung/tagesschau,61876e2a8b25b1230cf7a2c2.html|Tagesschau|Nachrichten"));
+    QCOMPARE(rows.at(2),
+             QStringLiteral("23:45|01:15|09.11.|https://www.tvspielfilm.de/tv-programm/sendung/der-grosse-krimi,61876e2a8b25b1230cf7a2c4.html|")
+                 + QString::fromUtf8("Der gro\xc3\x9f" "e Krimi") + QStringLiteral("|Krimi"));
+}
+
+void TvSpielfilmParserTest::lastRow_data()
+{
+    QTest::addColumn<int>("padding");
+
+    // the page ends a few bytes after the last marker, i.e. it is found by the byte-wise tail loop or the last word
+    for (int padding = 0; padding < 16; ++padding) {
+        QTest::newRow(qPrintable(QString::number(padding))) << padding;
+    }
+}
+
+void TvSpielfilmParserTest::lastRow()
+{
+    QFETCH(int, padding);
+
+    const QByteArray row =
+        "<tr class=\"hover\"><td class=\"col-2\"><div><strong>20:15 - 21:45</strong></div><span>Mi 10.11.</span></td>"
+        "<td class=\"col-3\"><a href=\"https://www.tvspielfilm.de/tv-programm/sendung/tatort,1.html\"><strong>Tatort</strong></a></td>"
+        "<td class=\"col-4\"><span>Krimi</span></td>";
+    // without "</tr>"
+    const QByteArray page = row + QByteArray(padding, ' ');
+
+    const QStringList rows = parseRows(page);
+    QCOMPARE(rows, QStringList{QStringLiteral("20:15|21:45|10.11.|https://www.tvspielfilm.de/tv-programm/sendung/tatort,1.html|Tatort|Krimi")});
+}
+
+void TvSpielfilmParserTest::pageCount()
+{
+    QCOMPARE(TvSpielfilmParser(m_programPage).pageCount(), 3);
+    QCOMPARE(TvSpielfilmParser(QByteArray("<html></html>")).pageCount(), 1);
+}
+
+void TvSpielfilmParserTest::description()
+{
+    QCOMPARE(TvSpielfilmParser::description(readFixture(QStringLiteral("tvspielfilm-description.html"))), QStringLiteral("Nachrichten aus aller Welt."));
+    QCOMPARE(TvSpielfilmParser::description(m_programPage), QString());
+}
+
+void TvSpielfilmParserTest::throughput()
+{
+    // the two valid rows of the fixture, repeated to the size of a long real page
+    const QByteArray rowMarker("<tr class=\"hover\">");
+    const int first = m_programPage.indexOf(rowMarker);
+    const int third = m_programPage.indexOf(rowMarker, m_programPage.indexOf(rowMarker, first + 1) + 1);
+    QVERIFY(first >= 0 && third > first);
+    const QByteArray page = m_programPage.mid(first, third - first).repeated(100);
+
+    // at least 200 ms (the result of a single parse would be mostly timer resolution)
+    int iterations = 0;
+    int rowCount = 0;
+    QElapsedTimer timer;
+    timer.start();
+    do {
+        TvSpielfilmParser parser(page);
+        TvSpielfilmParser::Row row;
+        while (parser.nextRow(row)) {
+            ++rowCount;
+        }
+        ++iterations;
+    } while (timer.elapsed() < 200);
+    const qint64 elapsedNs = qMax(timer.nsecsElapsed(), Q_INT64_C(1));
+
+    QCOMPARE(rowCount, 200 * iterations);
+    const qreal bytesPerSecond = static_cast<qreal>(page.size()) * iterations * 1e9 / elapsedNs;
+    QTest::setBenchmarkResult(bytesPerSecond, QTest::BytesPerSecond);
+    qInfo().nospace() << "parsed " << page.size() << " bytes " << iterations << " times: " << bytesPerSecond / 1e6 << " MB/s";
+}
+
+QTEST_GUILESS_MAIN(TvSpielfilmParserTest)
+
+#include "tvspielfilmparsertest.moc"
@@ -0,0 +1,158 @@
+#include "replayserver.h"
+
+#include "channeldata.h"
+#include "database.h"
+#include "fetcher.h"
+#include "fetchmetrics.h"
+#include "networkfetcher.h"
+#include "parserpool.h"
+#include "startup.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QStandardPaths>
+#include <QTest>
+
+namespace
+{
+const int IDLE_TIMEOUT = 10 * 60 * 1000; // [ms]
+}
+
+// fetches the programs of synthetic favorites from a local ReplayServer (end-to-end: network, parsing, database)
+// runs on a separate database (QStandardPaths test mode), the real one is not touched
+// environment: TELLY_SKOUT_REPLAY_FIXTURES=<directory> (recorded responses), TELLY_SKOUT_METRICS=<file> (FetchMetrics JSON of every row)
+class FetchBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void fetchFavorites_data();
+    void fetchFavorites();
+
+private:
+    QVector<ChannelData> addFavorites(int count); // replaces the previous favorites
+
+    const CountryId m_countryId = CountryId(QStringLiteral("benchmark"));
+    int m_run = 0; // new channels for every row (nothing is fetched already)
+};
+
+void FetchBenchmark::initTestCase()
+{
+    QCoreApplication::setApplicationName(QStringLiteral("telly-skout-benchmark"));
+    QStandardPaths::setTestModeEnabled(true);
+    QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).removeRecursively();
+    Startup::instance().openDatabase();
+    Database::instance().addCountry(m_countryId, QStringLiteral("Benchmark"), QString());
+}
+
+void FetchBenchmark::fetchFavorites_data()
+{
+    QTest::addColumn<int>("favoriteCount");
+    QTest::addColumn<int>("latency"); // [ms]
+    QTest::addColumn<qint64>("bandwidth"); // [bytes/s]
+    QTest::addColumn<double>("errorRate");
+    QTest::addColumn<int>("pageCount");
+
+    QTest::newRow("10 favorites") << 10 << 0 << Q_INT64_C(0) << 0.0 << 1;
+    QTest::newRow("100 favorites") << 100 << 0 << Q_INT64_C(0) << 0.0 << 1;
+    QTest::newRow("100 favorites, 3 pages") << 100 << 0 << Q_INT64_C(0) << 0.0 << 3;
+    QTest::newRow("100 favorites, 50 ms latency") << 100 << 50 << Q_INT64_C(0) << 0.0 << 1;
+    QTest::newRow("100 favorites, 1 MB/s") << 100 << 0 << Q_INT64_C(1000000) << 0.0 << 1;
+    QTest::newRow("100 favorites, 5% errors") << 100 << 0 << Q_INT64_C(0) << 0.05 << 1;
+}
+
+void FetchBenchmark::fetchFavorites()
+{
+    QFETCH(int, favoriteCount);
+    QFETCH(int, latency);
+    QFETCH(qint64, bandwidth);
+    QFETCH(double, errorRate);
+    QFETCH(int, pageCount);
+
+    ReplayServer::Settings settings;
+    settings.m_fixtureDirectory = qEnvironmentVariable("TELLY_SKOUT_REPLAY_FIXTURES");
+    settings.m_latency = latency;
+    settings.m_bandwidth = bandwidth;
+    settings.m_errorRate = errorRate;
+    settings.m_pageCount = pageCount;
+
+    ReplayServer server(settings);
+    QVERIFY(server.listen());
+    NetworkFetcher::setUrlOverride(server.url());
+
+    const QVector<ChannelData> channels = addFavorites(favoriteCount);
+    Database &database = Database::instance();
+    FetchMetrics::instance().reset();
+
+    QObject context; // disconnects the lambdas below (they capture locals)
+    qint64 parseTime = 0; // [us]
+    int parseJobs = 0;
+    int failedChannels = 0;
+    connect(&ParserPool::instance(), &ParserPool::jobFinished, &context, [&parseTime, &parseJobs](const QString &, qint64, qint64 jobParseTime) {
+        parseTime += jobParseTime;
+        ++parseJobs;
+    });
+    connect(&Fetcher::instance(), &Fetcher::errorFetchingChannel, &context, [&failedChannels]() {
+        ++failedChannels;
+    });
+    const qint64 databaseTimeBefore = database.busyTime();
+
+    QBENCHMARK_ONCE {
+        Fetcher::instance().fetchFavorites();
+        QTRY_VERIFY_WITH_TIMEOUT(Fetcher::instance().isIdle(), IDLE_TIMEOUT);
+    }
+
+    const qint64 databaseTime = database.busyTime() - databaseTimeBefore;
+    qint64 programCount = 0;
+    for (const ChannelData &channel : channels) {
+        programCount += database.programCount(channel.m_id);
+    }
+    qInfo().nospace() << "favorites: " << favoriteCount << " (" << failedChannels << " failed), programs: " << programCount
+                      << ", requests: " << server.requestCount() << " (" << server.errorCount() << " failed, " << server.bytesSent() / 1024
+                      << " KiB), parse time: " << parseTime / 1000 << " ms (" << parseJobs << " jobs, sum of all threads), DB time: " << databaseTime / 1000
+                      << " ms";
+
+    const QString metricsPath = qEnvironmentVariable("TELLY_SKOUT_METRICS");
+    if (!metricsPath.isEmpty()) {
+        FetchMetrics::instance().saveJson(metricsPath + QLatin1Char('.') + QString::number(m_run));
+    }
+
+    NetworkFetcher::setUrlOverride(QUrl());
+    if (errorRate == 0) {
+        QCOMPARE(failedChannels, 0);
+    }
+}
+
+QVector<ChannelData> FetchBenchmark::addFavorites(int count)
+{
+    ++m_run;
+
+    // every second one from each provider
+    QVector<ChannelData> channels;
+    channels.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        ChannelData channel;
+        if (i % 2 == 0) {
+            channel.m_id = ChannelId(QStringLiteral("benchmark%1-%2.xmltv.se").arg(m_run).arg(i));
+            channel.m_url = QStringLiteral("http://xmltv.xmltv.se/") + channel.m_id.value();
+        } else {
+            channel.m_id = ChannelId(QStringLiteral("BENCH%1X%2").arg(m_run).arg(i));
+            channel.m_url = QStringLiteral("https://www.tvspielfilm.de/tv-programm/sendungen/benchmark-%1,%2.html").arg(i).arg(channel.m_id.value());
+        }
+        channel.m_name = QStringLiteral("Benchmark %1").arg(i);
+        channels.append(channel);
+    }
+
+    Database &database = Database::instance();
+    database.clearFavorites();
+    database.addChannels(channels, m_countryId);
+    for (const ChannelData &channel : qAsConst(channels)) {
+        database.addFavorite(channel.m_id);
+    }
+    return channels;
+}
+
+QTEST_GUILESS_MAIN(FetchBenchmark)
+
+#include "fetchbenchmark.moc"
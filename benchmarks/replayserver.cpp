@@ -0,0 +1,280 @@
+#include "replayserver.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QHostAddress>
+#include <QLocale>
+#include <QRegularExpression>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUrlQuery>
+
+namespace
+{
+const quint32 RANDOM_SEED = 1;
+const int SEND_INTERVAL = 10; // [ms] between chunks if the bandwidth is limited
+
+// typical length of a real description
+const char SYNTHETIC_DESCRIPTION[] =
+    "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore et dolore magna aliqua. Ut enim ad minim "
+    "veniam, quis nostrud exercitation ullamco laboris nisi ut aliquip ex ea commodo consequat. Duis aute irure dolor in reprehenderit in voluptate "
+    "velit esse cillum dolore eu fugiat nulla pariatur.";
+
+QByteArray reasonPhrase(int status)
+{
+    switch (status) {
+    case 200:
+        return "OK";
+    case 404:
+        return "Not Found";
+    default:
+        return "Service Unavailable";
+    }
+}
+}
+
+struct ReplayServer::Connection {
+    QTcpSocket *m_socket = nullptr;
+    QByteArray m_received; // requests which are not handled yet
+    QByteArray m_response; // not sent yet
+    bool m_responding = false;
+};
+
+ReplayServer::ReplayServer(const Settings &settings, QObject *parent)
+    : QObject(parent)
+    , m_settings(settings)
+    , m_random(RANDOM_SEED)
+{
+    m_settings.m_pageCount = qMax(m_settings.m_pageCount, 1);
+    m_settings.m_programsPerDay = qMax(m_settings.m_programsPerDay, 1);
+
+    connect(&m_server, &QTcpServer::newConnection, this, &ReplayServer::onNewConnection);
+}
+
+bool ReplayServer::listen()
+{
+    if (!m_server.listen(QHostAddress::LocalHost)) {
+        qWarning() << "Failed to start replay server:" << m_server.errorString();
+        return false;
+    }
+    return true;
+}
+
+QUrl ReplayServer::url() const
+{
+    QUrl url;
+    url.setScheme(QStringLiteral("http"));
+    url.setHost(m_server.serverAddress().toString());
+    url.setPort(m_server.serverPort());
+    return url;
+}
+
+int ReplayServer::requestCount() const
+{
+    return m_requestCount;
+}
+
+int ReplayServer::errorCount() const
+{
+    return m_errorCount;
+}
+
+qint64 ReplayServer::bytesSent() const
+{
+    return m_bytesSent;
+}
+
+void ReplayServer::onNewConnection()
+{
+    while (QTcpSocket *socket = m_server.nextPendingConnection()) {
+        std::shared_ptr<Connection> connection = std::make_shared<Connection>();
+        connection->m_socket = socket;
+        connect(socket, &QTcpSocket::readyRead, this, [this, connection]() {
+            connection->m_received += connection->m_socket->readAll();
+            readRequests(connection);
+        });
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    }
+}
+
+void ReplayServer::readRequests(const std::shared_ptr<Connection> &connection)
+{
+    // one request after the other (keep-alive, no pipelining)
+    if (connection->m_responding) {
+        return;
+    }
+    const int headerEnd = connection->m_received.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        return;
+    }
+
+    // e.g. "GET /xmltv.xmltv.se/3sat.de_2021-07-29.xml HTTP/1.1" (GET only, i.e. there is no body)
+    const QByteArray requestLine = connection->m_received.left(connection->m_received.indexOf("\r\n"));
+    connection->m_received.remove(0, headerEnd + 4);
+    const QList<QByteArray> parts = requestLine.split(' ');
+    const QByteArray target = parts.size() == 3 ? parts.at(1) : QByteArray("/");
+
+    connection->m_responding = true;
+    ++m_requestCount;
+    if (m_settings.m_latency > 0) {
+        QTimer::singleShot(m_settings.m_latency, connection->m_socket, [this, connection, target]() {
+            respond(connection, target);
+        });
+    } else {
+        respond(connection, target);
+    }
+}
+
+void ReplayServer::respond(const std::shared_ptr<Connection> &connection, const QByteArray &target)
+{
+    int status = 200;
+    QByteArray body;
+    if (m_settings.m_errorRate > 0 && m_random.generateDouble() < m_settings.m_errorRate) {
+        status = 503;
+    } else {
+        body = fixture(target);
+        if (body.isNull()) {
+            body = synthetic(QUrl::fromEncoded(target), status);
+        }
+    }
+    if (status != 200) {
+        ++m_errorCount;
+    }
+    m_bytesSent += body.size();
+
+    connection->m_response = "HTTP/1.1 " + QByteArray::number(status) + ' ' + reasonPhrase(status) + "\r\n" + "Content-Length: " + QByteArray::number(body.size())
+        + "\r\n\r\n" + body;
+    send(connection);
+}
+
+void ReplayServer::send(const std::shared_ptr<Connection> &connection)
+{
+    if (m_settings.m_bandwidth > 0) {
+        const int chunkSize = static_cast<int>(qMax<qint64>(m_settings.m_bandwidth * SEND_INTERVAL / 1000, 1));
+        connection->m_socket->write(connection->m_response.left(chunkSize));
+        connection->m_response.remove(0, chunkSize);
+        if (!connection->m_response.isEmpty()) {
+            QTimer::singleShot(SEND_INTERVAL, connection->m_socket, [this, connection]() {
+                send(connection);
+            });
+            return;
+        }
+    } else {
+        connection->m_socket->write(connection->m_response);
+        connection->m_response.clear();
+    }
+
+    connection->m_responding = false;
+    readRequests(connection);
+}
+
+QByteArray ReplayServer::fixture(const QByteArray &target) const
+{
+    if (m_settings.m_fixtureDirectory.isEmpty()) {
+        return QByteArray();
+    }
+    const QByteArray name = QUrl::toPercentEncoding(QUrl::fromPercentEncoding(target.mid(1)), "/");
+    QFile file(m_settings.m_fixtureDirectory + QStringLiteral("/") + QString::fromLatin1(name));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+QByteArray ReplayServer::synthetic(const QUrl &url, int &status) const
+{
+    // e.g. "/www.tvspielfilm.de/tv-programm/sendungen/"
+    const QString path = url.path();
+    const int hostEnd = path.indexOf(QLatin1Char('/'), 1);
+    const QString host = path.mid(1, hostEnd < 0 ? -1 : hostEnd - 1);
+    const QString hostPath = hostEnd < 0 ? QStringLiteral("/") : path.mid(hostEnd);
+    const QUrlQuery query(url);
+
+    if (host.endsWith(QLatin1String("xmltv.se"))) {
+        // e.g. "/3sat.de_2021-07-29.xml"
+        static const QRegularExpression programsPath(QStringLiteral("^/(.+)_(\\d{4}-\\d{2}-\\d{2})\\.xml$"));
+        const QRegularExpressionMatch match = programsPath.match(hostPath);
+        if (match.hasMatch()) {
+            return xmlTvSePrograms(match.captured(1), QDate::fromString(match.captured(2), Qt::ISODate));
+        }
+    } else if (host.endsWith(QLatin1String("tvspielfilm.de"))) {
+        if (hostPath == QLatin1String("/tv-programm/sendungen/") && query.hasQueryItem(QStringLiteral("channel"))) {
+            const QDate day = QDate::fromString(query.queryItemValue(QStringLiteral("date")), Qt::ISODate);
+            const int page = qMax(query.queryItemValue(QStringLiteral("page")).toInt(), 1);
+            if (day.isValid() && page <= m_settings.m_pageCount) {
+                return tvSpielfilmPrograms(query.queryItemValue(QStringLiteral("channel")), day, page);
+            }
+        } else if (hostPath.startsWith(QLatin1String("/tv-programm/sendung/"))) {
+            return tvSpielfilmDescription(hostPath);
+        }
+    }
+
+    status = 404;
+    return QByteArray();
+}
+
+QByteArray ReplayServer::xmlTvSePrograms(const QString &channel, const QDate &day) const
+{
+    const QByteArray channelId = channel.toHtmlEscaped().toUtf8();
+    const QDateTime dayStart(day, QTime(0, 0), Qt::UTC);
+    const int duration = 24 * 3600 / m_settings.m_programsPerDay; // [s]
+
+    QByteArray xml = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<tv generator-info-name=\"telly-skout-replay\">\n";
+    for (int i = 0; i < m_settings.m_programsPerDay; ++i) {
+        const QDateTime start = dayStart.addSecs(i * duration);
+        const QDateTime stop = start.addSecs(duration);
+        const QByteArray number = QByteArray::number(i + 1);
+        xml += "  <programme start=\"" + start.toString(QStringLiteral("yyyyMMddHHmmss")).toLatin1() + " +0000\" stop=\""
+            + stop.toString(QStringLiteral("yyyyMMddHHmmss")).toLatin1() + " +0000\" channel=\"" + channelId + "\">\n";
+        xml += "    <title lang=\"de\">Program " + number + "</title>\n";
+        xml += "    <sub-title lang=\"de\">Episode " + number + "</sub-title>\n";
+        xml += "    <desc lang=\"de\">" + QByteArray(SYNTHETIC_DESCRIPTION) + "</desc>\n";
+        xml += "    <category lang=\"de\">Series</category>\n";
+        xml += "  </programme>\n";
+    }
+    xml += "</tv>\n";
+    return xml;
+}
+
+QByteArray ReplayServer::tvSpielfilmPrograms(const QString &channel, const QDate &day, int page) const
+{
+    const QByteArray channelId = channel.toHtmlEscaped().toUtf8();
+    const QByteArray date = day.toString(Qt::ISODate).toLatin1();
+    const QDateTime dayStart(day, QTime(0, 0));
+    const int duration = 24 * 3600 / m_settings.m_programsPerDay; // [s]
+    const int programsPerPage = (m_settings.m_programsPerDay + m_settings.m_pageCount - 1) / m_settings.m_pageCount;
+    const int first = (page - 1) * programsPerPage;
+    const int last = qMin(first + programsPerPage, m_settings.m_programsPerDay);
+
+    QByteArray html = "<!DOCTYPE html>\n<html><body>\n<table class=\"info-table\"><tbody>\n";
+    for (int i = first; i < last; ++i) {
+        const QDateTime start = dayStart.addSecs(i * duration);
+        const QDateTime stop = start.addSecs(duration);
+        const QByteArray number = QByteArray::number(i + 1);
+        html += "<tr class=\"hover\">\n<td class=\"col-2\"><strong>" + start.toString(QStringLiteral("HH:mm")).toLatin1() + " - "
+            + stop.toString(QStringLiteral("HH:mm")).toLatin1() + "</strong><span>" + QLocale::c().toString(start, QStringLiteral("ddd dd.MM.")).toLatin1()
+            + "</span></td>\n";
+        html += "<td class=\"col-3\"><a href=\"https://www.tvspielfilm.de/tv-programm/sendung/program-" + number + "," + channelId + "-" + date + "-" + number
+            + ".html\" title=\"Program " + number + "\"><strong>Program " + number + "</strong></a></td>\n";
+        html += "<td class=\"col-4\"><span>Serie</span></td>\n</tr>\n";
+    }
+    html += "</tbody></table>\n";
+
+    if (m_settings.m_pageCount > 1) {
+        html += "<ul class=\"pagination__items\">\n";
+        for (int p = 1; p <= m_settings.m_pageCount; ++p) {
+            html += "<li><a href=\"https://www.tvspielfilm.de/tv-programm/sendungen/?time=day&amp;channel=" + channelId + "&amp;date=" + date
+                + "&amp;page=" + QByteArray::number(p) + "\" class=\"js-track-link pagination__link\">" + QByteArray::number(p) + "</a></li>\n";
+        }
+        html += "</ul>\n";
+    }
+    html += "</body></html>\n";
+    return html;
+}
+
+QByteArray ReplayServer::tvSpielfilmDescription(const QString &path) const
+{
+    return "<!DOCTYPE html>\n<html><body>\n<h1>" + path.toHtmlEscaped().toUtf8() + "</h1>\n<section class=\"broadcast-detail__description\"><p>"
+        + QByteArray(SYNTHETIC_DESCRIPTION) + "</p></section>\n</body></html>\n";
+}
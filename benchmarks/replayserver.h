@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QObject>
+
+#include <QByteArray>
+#include <QDate>
+#include <QRandomGenerator>
+#include <QString>
+#include <QTcpServer>
+#include <QUrl>
+
+#include <memory>
+
+class QTcpSocket;
+
+// local HTTP stand-in for the providers (offline benchmarks, reproducible fetches)
+// used with NetworkFetcher::setUrlOverride(), i.e. the original host is the first path segment
+// responses come from the fixture directory if there is a file for the request, otherwise they are synthetic (xmltv.se, TV Spielfilm)
+class ReplayServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Settings {
+        // recorded responses: <directory>/<host>/<path>[?query], percent encoded except for '/' (e.g. saved with curl)
+        QString m_fixtureDirectory;
+        int m_latency = 0; // [ms] until the response starts
+        qint64 m_bandwidth = 0; // [bytes/s] per connection, 0 = unlimited
+        double m_errorRate = 0; // share of requests which fail with "503 Service Unavailable"
+        int m_pageCount = 1; // pages per day (TV Spielfilm)
+        int m_programsPerDay = 48;
+    };
+
+    explicit ReplayServer(const Settings &settings, QObject *parent = nullptr);
+
+    bool listen(); // localhost, any free port
+    QUrl url() const;
+
+    int requestCount() const;
+    int errorCount() const;
+    qint64 bytesSent() const; // bodies only
+
+private:
+    struct Connection;
+
+    void onNewConnection();
+    void readRequests(const std::shared_ptr<Connection> &connection);
+    void respond(const std::shared_ptr<Connection> &connection, const QByteArray &target);
+    void send(const std::shared_ptr<Connection> &connection);
+
+    QByteArray fixture(const QByteArray &target) const; // null if there is none
+    QByteArray synthetic(const QUrl &url, int &status) const;
+    QByteArray xmlTvSePrograms(const QString &channel, const QDate &day) const;
+    QByteArray tvSpielfilmPrograms(const QString &channel, const QDate &day, int page) const;
+    QByteArray tvSpielfilmDescription(const QString &path) const;
+
+    Settings m_settings;
+    QTcpServer m_server;
+    QRandomGenerator m_random; // fixed seed: same errors in every run
+    int m_requestCount = 0;
+    int m_errorCount = 0;
+    qint64 m_bytesSent = 0;
+};
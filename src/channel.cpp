@@ -1,8 +1,7 @@
 #include "channel.h"
 
 #include "database.h"
-#include "fetcher.h"
-#include "program.h"
+#include "eventhub.h"
 #include "programfactory.h"
 #include "programsmodel.h"
 #include "types.h"
@@ -15,28 +14,18 @@ Channel::Channel(const ChannelData &data, bool favorite, const QVector<QString>
     , m_favorite(favorite)
     , m_countries(countryIds)
 {
-    connect(&Fetcher::instance(), &Fetcher::startedFetchingChannel, this, [this](const ChannelId &id) {
-        if (id == m_data.m_id) {
-            setRefreshing(true);
-        }
+    EventHub &eventHub = EventHub::instance();
+    eventHub.channelFetchStarted().subscribe(m_data.m_id, this, [this]() {
+        setRefreshing(true);
     });
-    connect(&Fetcher::instance(), &Fetcher::channelUpdated, this, [this](const ChannelId &id) {
-        if (id == m_data.m_id) {
-            setRefreshing(false);
-            Q_EMIT programChanged();
-            m_error.reset();
-        }
+    eventHub.channelUpdated().subscribe(m_data.m_id, this, [this]() {
+        setRefreshing(false);
+        Q_EMIT programChanged();
+        m_error.reset();
     });
-    connect(&Fetcher::instance(), &Fetcher::errorFetchingChannel, this, [this](const ChannelId &id, const Error &error) {
-        if (id == m_data.m_id) {
-            setError(error);
-            setRefreshing(false);
-        }
-    });
-    connect(&Fetcher::instance(), &Fetcher::imageDownloadFinished, this, [this](const QString &url) {
-        if (url == m_data.m_image) {
-            Q_EMIT imageChanged(url);
-        }
+    eventHub.channelFetchFailed().subscribe(m_data.m_id, this, [this](const Error &error) {
+        setError(error);
+        setRefreshing(false);
     });
 
     // programs
@@ -92,6 +81,11 @@ QString Channel::errorString() const
     return m_error.m_message;
 }
 
+ProgramsModel *Channel::programsModel() const
+{
+    return m_programsModel;
+}
+
 void Channel::setName(const QString &name)
 {
     m_data.m_name = name;
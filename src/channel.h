@@ -6,7 +6,6 @@
 
 #include <QVector>
 
-class Program;
 class ProgramFactory;
 class ProgramsModel;
 
@@ -23,7 +22,7 @@ class Channel : public QObject
     Q_PROPERTY(bool refreshing READ refreshing WRITE setRefreshing NOTIFY refreshingChanged)
     Q_PROPERTY(int errorId READ errorId NOTIFY errorIdChanged)
     Q_PROPERTY(QString errorString READ errorString NOTIFY errorStringChanged)
-    Q_PROPERTY(ProgramsModel *programsModel MEMBER m_programsModel CONSTANT)
+    Q_PROPERTY(ProgramsModel *programsModel READ programsModel CONSTANT)
 
 public:
     Channel(const ChannelData &data, bool favorite, const QVector<QString> &countryIds, ProgramFactory &programFactory);
@@ -39,6 +38,7 @@ public:
     int programCount() const;
     int errorId() const;
     QString errorString() const;
+    ProgramsModel *programsModel() const;
 
     bool refreshing() const;
 
@@ -1,26 +1,40 @@
 #include "channelfactory.h"
 
 #include "channel.h"
+#include "channelsearchindex.h"
 #include "countrydata.h"
 #include "database.h"
 #include "fetcher.h"
+#include "startup.h"
+#include "tracer.h"
 
 #include <QDebug>
+#include <QHash>
+#include <QSet>
 
 #include <algorithm>
 
+namespace
+{
+// country ID <-> bit in the country bitsets (only grows)
+QHash<CountryId, int> countryIndices;
+QVector<CountryId> countryIdList; // index -> ID
+}
+
 ChannelFactory::ChannelFactory(bool onlyFavorites)
     : QObject(nullptr)
     , m_onlyFavorites(onlyFavorites)
 {
-    load();
+    // loaded by the model as soon as the database is ready
 }
 
 void ChannelFactory::setOnlyFavorites(bool onlyFavorites)
 {
     if (m_onlyFavorites != onlyFavorites) {
         m_onlyFavorites = onlyFavorites;
-        load();
+        if (Startup::instance().isDatabaseReady()) {
+            load();
+        }
     }
 }
 
@@ -39,54 +53,170 @@ Channel *ChannelFactory::create(int index) const
     if (m_channels.size() <= index) {
         return nullptr;
     }
-    const ChannelData &data = m_channels.at(index);
+    const Entry &entry = m_channels.at(index);
+    return new Channel(entry.m_data, entry.m_favorite, countryIds(entry.m_countries), m_programFactory);
+}
+
+void ChannelFactory::load() const
+{
+    m_channels = query();
+    m_rowsValid = false;
+}
+
+QVector<ChannelFactory::Entry> ChannelFactory::query() const
+{
+    TRACE_FUNCTION("model");
+    const QVector<ChannelData> channels = Database::instance().channels(m_onlyFavorites);
 
-    // check if channel is favorite
-    // if onlyFavorites == true, it must be a favorite
-    // but onlyFavorites == false does not mean that it cannot be favorite
-    bool favorite = m_onlyFavorites;
+    // all at once (instead of one query per channel)
+    QSet<ChannelId> favorites;
     if (!m_onlyFavorites) {
-        favorite = Database::instance().isFavorite(data.m_id);
+        const QVector<ChannelId> favoriteIds = Database::instance().favorites();
+        favorites = QSet<ChannelId>(favoriteIds.begin(), favoriteIds.end());
+    }
+    const QMultiHash<ChannelId, CountryId> channelCountries = Database::instance().channelCountries();
+
+    QVector<Entry> entries;
+    entries.reserve(channels.size());
+    for (const ChannelData &data : channels) {
+        Entry entry;
+        entry.m_data = data;
+        // if onlyFavorites == true, it must be a favorite
+        // but onlyFavorites == false does not mean that it cannot be favorite
+        entry.m_favorite = m_onlyFavorites || favorites.contains(data.m_id);
+        entry.m_countries = countryBits(channelCountries.values(data.m_id).toVector());
+        entry.m_searchKey = ChannelSearchIndex::instance().key(data.m_id);
+        entries.append(entry);
     }
+    return entries;
+}
 
-    const QVector<CountryData> countries = Database::instance().countries(data.m_id);
-    QVector<QString> countryIds(countries.size());
-    std::transform(countries.begin(), countries.end(), countryIds.begin(), [](const CountryData &data) {
-        return data.m_id.value();
+ChannelFactory::Entry ChannelFactory::queryChannel(const ChannelId &id) const
+{
+    Entry entry;
+    entry.m_data = Database::instance().channel(id);
+    entry.m_favorite = m_onlyFavorites || Database::instance().isFavorite(id);
+    const QVector<CountryData> countries = Database::instance().countries(id);
+    QVector<CountryId> ids(countries.size());
+    std::transform(countries.begin(), countries.end(), ids.begin(), [](const CountryData &data) {
+        return data.m_id;
     });
+    entry.m_countries = countryBits(ids);
+    entry.m_searchKey = ChannelSearchIndex::instance().key(id);
+    return entry;
+}
 
-    return new Channel(data, favorite, countryIds, m_programFactory);
+void ChannelFactory::update(const ChannelId &id)
+{
+    // favorites which are added or removed are applied by the model (see ChannelsModel::reload())
+    const int index = indexOf(id);
+    if (index >= 0) {
+        m_channels[index].m_data = Database::instance().channel(id);
+        m_channels[index].m_favorite = m_onlyFavorites || Database::instance().isFavorite(id);
+    } else if (!m_onlyFavorites) {
+        m_channels.append(queryChannel(id));
+        m_rows.insert(id, m_channels.size() - 1);
+    }
 }
 
-void ChannelFactory::load() const
+ProgramFactory &ChannelFactory::programFactory()
 {
-    m_channels.clear();
-    m_channels = Database::instance().channels(m_onlyFavorites);
+    return m_programFactory;
 }
 
-void ChannelFactory::update(const ChannelId &id)
+void ChannelFactory::insert(int index, const Entry &entry)
 {
-    if (m_onlyFavorites) {
-        // remove if no favorite anymore
-        if (!Database::instance().isFavorite(id)) {
-            QVector<ChannelData>::iterator it = std::find_if(m_channels.begin(), m_channels.end(), [id](const ChannelData &data) {
-                return data.m_id == id;
-            });
-            if (it != m_channels.end()) {
-                m_channels.erase(it);
-            }
-        } else {
-            // reload favorites if favorite added or maybe favorite order changed
-            load();
+    m_channels.insert(index, entry);
+    m_rowsValid = false;
+}
+
+void ChannelFactory::remove(int index, int count)
+{
+    m_channels.remove(index, count);
+    m_rowsValid = false;
+}
+
+void ChannelFactory::replace(int index, const Entry &entry)
+{
+    m_channels[index] = entry; // same ID
+}
+
+void ChannelFactory::move(int from, int to)
+{
+    m_channels.move(from, to);
+    m_rowsValid = false;
+}
+
+int ChannelFactory::indexOf(const ChannelId &id) const
+{
+    if (!m_rowsValid) {
+        m_rows.clear();
+        m_rows.reserve(m_channels.size());
+        for (int i = 0; i < m_channels.size(); ++i) {
+            m_rows.insert(m_channels.at(i).m_data.m_id, i);
         }
-    } else {
-        QVector<ChannelData>::iterator it = std::find_if(m_channels.begin(), m_channels.end(), [id](const ChannelData &data) {
-            return data.m_id == id;
-        });
-        if (it != m_channels.end()) {
-            *it = Database::instance().channel(id);
-        } else {
-            m_channels.append(Database::instance().channel(id));
+        m_rowsValid = true;
+    }
+    return m_rows.value(id, -1);
+}
+
+const ChannelId &ChannelFactory::id(int index) const
+{
+    return m_channels.at(index).m_data.m_id;
+}
+
+bool ChannelFactory::isFavorite(int index) const
+{
+    return m_channels.at(index).m_favorite;
+}
+
+const QBitArray &ChannelFactory::countries(int index) const
+{
+    return m_channels.at(index).m_countries;
+}
+
+int ChannelFactory::searchKey(int index) const
+{
+    return m_channels.at(index).m_searchKey;
+}
+
+const ChannelFactory::Entry &ChannelFactory::entry(int index) const
+{
+    return m_channels.at(index);
+}
+
+int ChannelFactory::countryIndex(const CountryId &id)
+{
+    auto it = countryIndices.constFind(id);
+    if (it != countryIndices.constEnd()) {
+        return it.value();
+    }
+    const int index = countryIdList.size();
+    countryIndices.insert(id, index);
+    countryIdList.append(id);
+    return index;
+}
+
+QVector<QString> ChannelFactory::countryIds(const QBitArray &countries)
+{
+    QVector<QString> ids;
+    for (int i = 0; i < countries.size(); ++i) {
+        if (countries.testBit(i)) {
+            ids.append(countryIdList.at(i).value());
         }
     }
+    return ids;
+}
+
+QBitArray ChannelFactory::countryBits(const QVector<CountryId> &ids)
+{
+    QVector<int> indices(ids.size());
+    std::transform(ids.begin(), ids.end(), indices.begin(), &ChannelFactory::countryIndex);
+
+    // sized to the highest bit: the bitsets of the channels may differ in size
+    QBitArray bits(indices.isEmpty() ? 0 : *std::max_element(indices.begin(), indices.end()) + 1);
+    for (int index : qAsConst(indices)) {
+        bits.setBit(index);
+    }
+    return bits;
 }
@@ -6,6 +6,8 @@
 #include "programfactory.h"
 #include "types.h"
 
+#include <QBitArray>
+#include <QHash>
 #include <QVector>
 
 class Channel;
@@ -15,6 +17,13 @@ class ChannelFactory : public QObject
     Q_OBJECT
 
 public:
+    struct Entry {
+        ChannelData m_data;
+        bool m_favorite = false;
+        QBitArray m_countries;
+        int m_searchKey = -1;
+    };
+
     ChannelFactory(bool onlyFavorites);
     ~ChannelFactory() = default;
 
@@ -22,10 +31,35 @@ public:
     size_t count() const;
     Channel *create(int index) const;
     void load() const;
-    void update(const ChannelId &id);
+    QVector<Entry> query() const; // like load() but without storing the result (e.g. to compute changes)
+    void update(const ChannelId &id); // data of a single channel (only appends new ones if not only favorites)
+    ProgramFactory &programFactory(); // programs of the created channels
+
+    // changes applied by the model
+    void insert(int index, const Entry &entry);
+    void remove(int index, int count);
+    void replace(int index, const Entry &entry);
+    void move(int from, int to);
+
+    // plain data (e.g. to filter without creating a Channel)
+    int indexOf(const ChannelId &id) const; // -1 if unknown
+    const ChannelId &id(int index) const;
+    bool isFavorite(int index) const;
+    const QBitArray &countries(int index) const; // bit countryIndex() is set for every country of the channel
+    int searchKey(int index) const; // see ChannelSearchIndex
+    const Entry &entry(int index) const;
+
+    // stable while the application runs
+    static int countryIndex(const CountryId &id);
+    static QVector<QString> countryIds(const QBitArray &countries);
 
 private:
-    mutable QVector<ChannelData> m_channels;
+    Entry queryChannel(const ChannelId &id) const;
+    static QBitArray countryBits(const QVector<CountryId> &ids);
+
+    mutable QVector<Entry> m_channels;
+    mutable QHash<ChannelId, int> m_rows; // ID -> index in m_channels, rebuilt when needed after changes
+    mutable bool m_rowsValid = false;
     bool m_onlyFavorites;
     mutable ProgramFactory m_programFactory;
 };
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "types.h"
+
+#include <QString>
+
+// a channel as it is known by a provider (FetcherImpl)
+struct ChannelProviderData {
+    ChannelId m_channelId;
+    QString m_provider;
+    ChannelId m_providerChannelId;
+};
@@ -0,0 +1,144 @@
+#include "channelsearchindex.h"
+
+#include "channeldata.h"
+#include "database.h"
+#include "tracer.h"
+
+#include <QDebug>
+
+#include <algorithm>
+
+namespace
+{
+const int GRAM_SIZE = 3;
+
+quint64 trigram(const QString &text, int position)
+{
+    return (quint64(text.at(position).unicode()) << 32) | (quint64(text.at(position + 1).unicode()) << 16) | text.at(position + 2).unicode();
+}
+}
+
+ChannelSearchIndex::ChannelSearchIndex()
+    : QObject(nullptr)
+{
+    connect(&Database::instance(), &Database::channelAdded, this, [this](const ChannelId &id) {
+        // indexed when the next search needs it (channels are added in batches while fetching)
+        if (m_loaded) {
+            m_pending.append(id);
+        }
+    });
+}
+
+int ChannelSearchIndex::key(const ChannelId &id)
+{
+    auto it = m_keys.constFind(id);
+    if (it != m_keys.constEnd()) {
+        return it.value();
+    }
+    const int key = m_names.size();
+    m_keys.insert(id, key);
+    m_names.append(QString());
+    return key;
+}
+
+QString ChannelSearchIndex::normalized(const QString &text)
+{
+    // decompose to drop diacritics (e.g. "é" -> "e")
+    const QString decomposed = text.normalized(QString::NormalizationForm_KD);
+    QString normalized;
+    normalized.reserve(decomposed.size());
+    for (const QChar c : decomposed) {
+        if (c.isLetterOrNumber()) {
+            normalized.append(c.toLower());
+        }
+    }
+    return normalized;
+}
+
+QBitArray ChannelSearchIndex::match(const QString &text)
+{
+    TRACE_FUNCTION("model");
+    if (!m_loaded) {
+        load();
+    }
+    const bool added = !m_pending.isEmpty();
+    addPending();
+
+    const QString query = normalized(text);
+    QBitArray matches(m_names.size());
+    const auto check = [this, &query, &matches](int key) {
+        if (m_names.at(key).contains(query)) {
+            matches.setBit(key);
+        }
+    };
+
+    if (!added && !m_lastQuery.isEmpty() && query.contains(m_lastQuery)) {
+        // refine
+        for (int key = 0; key < m_lastMatches.size(); ++key) {
+            if (m_lastMatches.testBit(key)) {
+                check(key);
+            }
+        }
+    } else if (query.size() >= GRAM_SIZE) {
+        // candidates: the rarest trigram of the query
+        const QVector<int> *candidates = nullptr;
+        for (int i = 0; i + GRAM_SIZE <= query.size(); ++i) {
+            auto it = m_trigrams.constFind(trigram(query, i));
+            if (it == m_trigrams.constEnd()) {
+                candidates = nullptr;
+                break;
+            }
+            if (!candidates || it->size() < candidates->size()) {
+                candidates = &it.value();
+            }
+        }
+        if (candidates) {
+            for (int key : *candidates) {
+                check(key);
+            }
+        }
+    } else {
+        // short names are rare, the scan is cheap
+        for (int key = 0; key < m_names.size(); ++key) {
+            check(key);
+        }
+    }
+
+    m_lastQuery = query;
+    m_lastMatches = matches;
+    return matches;
+}
+
+void ChannelSearchIndex::load()
+{
+    TRACE_FUNCTION("model");
+    m_loaded = true;
+    for (const ChannelData &data : Database::instance().channels(false)) {
+        add(key(data.m_id), data.m_name);
+    }
+}
+
+void ChannelSearchIndex::addPending()
+{
+    for (const ChannelId &id : qAsConst(m_pending)) {
+        add(key(id), Database::instance().channel(id).m_name);
+    }
+    m_pending.clear();
+}
+
+void ChannelSearchIndex::add(int key, const QString &name)
+{
+    if (!m_names.at(key).isEmpty()) {
+        return;
+    }
+    const QString normalizedName = normalized(name);
+    m_names[key] = normalizedName;
+
+    for (int i = 0; i + GRAM_SIZE <= normalizedName.size(); ++i) {
+        QVector<int> &keys = m_trigrams[trigram(normalizedName, i)];
+        auto it = std::lower_bound(keys.begin(), keys.end(), key);
+        if (it == keys.end() || *it != key) {
+            keys.insert(it, key);
+        }
+    }
+}
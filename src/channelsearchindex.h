@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QObject>
+
+#include "types.h"
+
+#include <QBitArray>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+// infix search over the normalized names of all channels (trigram index)
+// every channel gets a stable key, matches are returned as a bitset over the keys
+// built on first use and kept up to date by Database::channelAdded
+// GUI thread only
+class ChannelSearchIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    static ChannelSearchIndex &instance()
+    {
+        static ChannelSearchIndex _instance;
+        return _instance;
+    }
+
+    int key(const ChannelId &id); // creates a key for unknown channels
+    QBitArray match(const QString &text); // keys of the channels whose name contains text
+
+    static QString normalized(const QString &text); // lower case, without diacritics, spaces and punctuation
+
+private:
+    ChannelSearchIndex();
+
+    void load();
+    void addPending();
+    void add(int key, const QString &name);
+
+    QHash<ChannelId, int> m_keys;
+    QVector<QString> m_names; // normalized, per key (empty if not indexed yet)
+    QHash<quint64, QVector<int>> m_trigrams; // -> sorted keys
+    QVector<ChannelId> m_pending; // added to the database but not indexed yet
+    bool m_loaded = false;
+
+    // type-ahead: a longer query only needs to check the matches of the previous one
+    QString m_lastQuery;
+    QBitArray m_lastMatches;
+};
@@ -3,63 +3,74 @@
 #include "channel.h"
 #include "database.h"
 #include "fetcher.h"
+#include "startup.h"
+#include "tracer.h"
 
 #include <QDebug>
-
-#include <algorithm>
+#include <QSet>
 
 ChannelsModel::ChannelsModel(QObject *parent)
     : QAbstractListModel(parent)
     , m_onlyFavorites(true) // deliberately lazy to save time if only favorites required
     , m_channelFactory(m_onlyFavorites)
 {
+    m_programsRangeTimer.setSingleShot(true);
+    m_programsRangeTimer.setInterval(0);
+    connect(&m_programsRangeTimer, &QTimer::timeout, this, &ChannelsModel::updateProgramsRange);
+
+    // empty until the database is open (see Startup)
+    Startup::instance().whenDatabaseReady(this, [this]() {
+        reload();
+        m_loaded = true;
+        Q_EMIT loadedChanged();
+    });
+
     connect(&Fetcher::instance(), &Fetcher::countryUpdated, this, [this](const CountryId &id) {
         Q_UNUSED(id)
-        beginResetModel();
-        qDeleteAll(m_channels);
-        m_channels.clear();
-        m_channelFactory.load();
-        endResetModel();
+        reload();
     });
 
     connect(&Fetcher::instance(), &Fetcher::channelDetailsUpdated, this, [this](const ChannelId &id, const QString &image) {
-        for (int i = 0; i < m_channels.length(); i++) {
-            if (m_channels[i]->id() == id.value()) {
-                m_channels[i]->setImage(image);
-                m_channelFactory.update(id);
-                Q_EMIT dataChanged(createIndex(i, 0), createIndex(i, 0));
-                break;
-            }
+        const int row = m_channelFactory.indexOf(id);
+        if (row < 0) {
+            return;
+        }
+        m_channelFactory.update(id);
+        if (row < m_channels.size() && m_channels[row]) {
+            m_channels[row]->setImage(image);
         }
+        Q_EMIT dataChanged(index(row, 0), index(row, 0));
     });
 
     connect(&Database::instance(), &Database::channelDetailsUpdated, this, [this](const ChannelId &id, bool favorite) {
         // with "only favorites", a row must be added/removed -> not sufficient to call only dataChanged()
         if (m_onlyFavorites) {
-            beginResetModel();
-            qDeleteAll(m_channels);
-            m_channels.clear();
+            reload();
+            return;
+        }
+
+        const int row = m_channelFactory.indexOf(id);
+        if (row < 0) {
+            const int count = m_channelFactory.count();
+            beginInsertRows(QModelIndex(), count, count);
             m_channelFactory.update(id);
-            endResetModel();
-        } else {
-            for (int i = 0; i < m_channels.length(); i++) {
-                if (m_channels[i]->id() == id.value()) {
-                    m_channels[i]->setFavorite(favorite);
-                    m_channelFactory.update(id);
-                    Q_EMIT dataChanged(createIndex(i, 0), createIndex(i, 0));
-                    break;
-                }
-            }
+            endInsertRows();
+            return;
+        }
+        m_channelFactory.update(id);
+        if (row < m_channels.size() && m_channels[row]) {
+            m_channels[row]->setFavorite(favorite);
         }
+        // filters (e.g. ChannelsProxyModel) are updated by the dataChanged()
+        Q_EMIT dataChanged(index(row, 0), index(row, 0));
     });
 
-    connect(&Database::instance(), &Database::favoritesUpdated, this, [this]() {
-        beginResetModel();
-        qDeleteAll(m_channels);
-        m_channels.clear();
-        m_channelFactory.load();
-        endResetModel();
-    });
+    connect(&Database::instance(), &Database::favoritesUpdated, this, &ChannelsModel::reload);
+}
+
+bool ChannelsModel::isLoaded() const
+{
+    return m_loaded;
 }
 
 bool ChannelsModel::onlyFavorites() const
@@ -73,10 +84,47 @@ void ChannelsModel::setOnlyFavorites(bool onlyFavorites)
     m_channelFactory.setOnlyFavorites(onlyFavorites);
 }
 
+QDateTime ChannelsModel::programsStart() const
+{
+    return m_programsStart;
+}
+
+void ChannelsModel::setProgramsStart(const QDateTime &start)
+{
+    if (m_programsStart != start) {
+        m_programsStart = start;
+        m_programsRangeTimer.start();
+        Q_EMIT programsRangeChanged();
+    }
+}
+
+QDateTime ChannelsModel::programsStop() const
+{
+    return m_programsStop;
+}
+
+void ChannelsModel::setProgramsStop(const QDateTime &stop)
+{
+    if (m_programsStop != stop) {
+        m_programsStop = stop;
+        m_programsRangeTimer.start();
+        Q_EMIT programsRangeChanged();
+    }
+}
+
+void ChannelsModel::updateProgramsRange()
+{
+    // apply only valid ranges
+    if (m_programsStart.isValid() && m_programsStop.isValid() && m_programsStart < m_programsStop) {
+        m_channelFactory.programFactory().setRange(m_programsStart.toSecsSinceEpoch(), m_programsStop.toSecsSinceEpoch());
+    }
+}
+
 QHash<int, QByteArray> ChannelsModel::roleNames() const
 {
     QHash<int, QByteArray> roleNames;
-    roleNames[0] = "channel";
+    roleNames[ChannelRole] = "channel";
+    roleNames[FavoriteRole] = "favorite";
     return roleNames;
 }
 
@@ -88,18 +136,118 @@ int ChannelsModel::rowCount(const QModelIndex &parent) const
 
 QVariant ChannelsModel::data(const QModelIndex &index, int role) const
 {
-    if (role != 0) {
+    if (!index.isValid() || index.row() >= static_cast<int>(m_channelFactory.count())) {
         return QVariant();
     }
-    if (m_channels.length() <= index.row()) {
-        loadChannel(index.row());
+
+    switch (role) {
+    case ChannelRole:
+        return QVariant::fromValue(channel(index.row()));
+    // plain data: does not create the Channel
+    case FavoriteRole:
+        return m_channelFactory.isFavorite(index.row());
+    case CountriesRole:
+        return m_channelFactory.countries(index.row());
+    case SearchKeyRole:
+        return m_channelFactory.searchKey(index.row());
+    default:
+        return QVariant();
     }
-    return QVariant::fromValue(m_channels[index.row()]);
 }
 
-void ChannelsModel::loadChannel(int index) const
+void ChannelsModel::reload()
 {
-    m_channels += m_channelFactory.create(index);
+    TRACE_FUNCTION("model");
+    // only the changed rows are updated (keeps the delegates of all others)
+    const QVector<ChannelFactory::Entry> channels = m_channelFactory.query();
+    m_channels.resize(m_channelFactory.count());
+
+    // remove channels which are gone (bottom up, consecutive rows at once)
+    QSet<ChannelId> ids;
+    ids.reserve(channels.size());
+    for (const ChannelFactory::Entry &entry : channels) {
+        ids.insert(entry.m_data.m_id);
+    }
+    for (int last = m_channelFactory.count() - 1; last >= 0;) {
+        if (ids.contains(m_channelFactory.id(last))) {
+            --last;
+            continue;
+        }
+        int first = last;
+        while (first > 0 && !ids.contains(m_channelFactory.id(first - 1))) {
+            --first;
+        }
+        beginRemoveRows(QModelIndex(), first, last);
+        m_channelFactory.remove(first, last - first + 1);
+        qDeleteAll(m_channels.begin() + first, m_channels.begin() + last + 1);
+        m_channels.remove(first, last - first + 1);
+        endRemoveRows();
+        last = first - 1;
+    }
+
+    // insert new channels, move and update existing ones (in the new order)
+    QSet<ChannelId> existing;
+    existing.reserve(m_channelFactory.count());
+    for (int row = 0; row < static_cast<int>(m_channelFactory.count()); ++row) {
+        existing.insert(m_channelFactory.id(row));
+    }
+    for (int row = 0; row < channels.size(); ++row) {
+        const ChannelFactory::Entry &entry = channels.at(row);
+
+        if (!existing.contains(entry.m_data.m_id)) {
+            int last = row;
+            while (last + 1 < channels.size() && !existing.contains(channels.at(last + 1).m_data.m_id)) {
+                ++last;
+            }
+            beginInsertRows(QModelIndex(), row, last);
+            for (int i = row; i <= last; ++i) {
+                m_channelFactory.insert(i, channels.at(i));
+                m_channels.insert(i, nullptr);
+            }
+            endInsertRows();
+            row = last;
+            continue;
+        }
+
+        if (m_channelFactory.id(row) != entry.m_data.m_id) {
+            // rare (e.g. favorites sorted): rows before are final already, i.e. it can only come from below
+            const int from = m_channelFactory.indexOf(entry.m_data.m_id);
+            beginMoveRows(QModelIndex(), from, from, QModelIndex(), row);
+            m_channelFactory.move(from, row);
+            m_channels.move(from, row);
+            endMoveRows();
+        }
+
+        if (!isSame(m_channelFactory.entry(row), entry)) {
+            m_channelFactory.replace(row, entry);
+            Channel *channel = m_channels.at(row);
+            if (channel) {
+                channel->setName(entry.m_data.m_name);
+                channel->setImage(entry.m_data.m_image);
+                channel->setFavorite(entry.m_favorite);
+                channel->setCountries(ChannelFactory::countryIds(entry.m_countries));
+            }
+            Q_EMIT dataChanged(index(row, 0), index(row, 0));
+        }
+    }
+}
+
+bool ChannelsModel::isSame(const ChannelFactory::Entry &l, const ChannelFactory::Entry &r)
+{
+    return l.m_data.m_id == r.m_data.m_id && l.m_data.m_name == r.m_data.m_name && l.m_data.m_url == r.m_data.m_url && l.m_data.m_image == r.m_data.m_image
+        && l.m_favorite == r.m_favorite && l.m_countries == r.m_countries;
+}
+
+Channel *ChannelsModel::channel(int index) const
+{
+    // created when they are shown (rows may be requested in any order)
+    if (m_channels.size() < static_cast<int>(m_channelFactory.count())) {
+        m_channels.resize(m_channelFactory.count());
+    }
+    if (!m_channels[index]) {
+        m_channels[index] = m_channelFactory.create(index);
+    }
+    return m_channels[index];
 }
 
 void ChannelsModel::setFavorite(const QString &channelId, bool favorite)
@@ -116,15 +264,19 @@ void ChannelsModel::move(int from, int to)
     const int destination = to > from ? to + 1 : to;
 
     beginMoveRows(QModelIndex(), from, from, QModelIndex(), destination);
+    if (m_channels.size() < static_cast<int>(m_channelFactory.count())) {
+        m_channels.resize(m_channelFactory.count());
+    }
     m_channels.move(from, to);
+    m_channelFactory.move(from, to);
     endMoveRows();
 }
 
 void ChannelsModel::save()
 {
-    QVector<ChannelId> channelIds(m_channels.size());
-    std::transform(m_channels.begin(), m_channels.end(), channelIds.begin(), [](const Channel *channel) {
-        return ChannelId(channel->id());
-    });
+    QVector<ChannelId> channelIds(m_channelFactory.count());
+    for (int i = 0; i < channelIds.size(); ++i) {
+        channelIds[i] = m_channelFactory.id(i);
+    }
     Database::instance().sortFavorites(channelIds);
 }
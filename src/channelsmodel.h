@@ -5,6 +5,8 @@
 #include "channelfactory.h"
 #include "types.h"
 
+#include <QDateTime>
+#include <QTimer>
 #include <QUrl>
 
 class Channel;
@@ -13,8 +15,20 @@ class ChannelsModel : public QAbstractListModel
 {
     Q_OBJECT
     Q_PROPERTY(bool onlyFavorites READ onlyFavorites WRITE setOnlyFavorites)
+    Q_PROPERTY(bool loaded READ isLoaded NOTIFY loadedChanged) // false while starting up
+    // programs running in [programsStart, programsStop) are kept in memory (default: the fetched days)
+    Q_PROPERTY(QDateTime programsStart READ programsStart WRITE setProgramsStart NOTIFY programsRangeChanged)
+    Q_PROPERTY(QDateTime programsStop READ programsStop WRITE setProgramsStop NOTIFY programsRangeChanged)
 
 public:
+    enum Role {
+        ChannelRole = Qt::DisplayRole,
+        FavoriteRole = Qt::UserRole + 1, // bool
+        CountriesRole, // QBitArray, see ChannelFactory::countryIndex()
+        SearchKeyRole, // int, see ChannelSearchIndex
+    };
+    Q_ENUM(Role)
+
     explicit ChannelsModel(QObject *parent = nullptr);
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
     QHash<int, QByteArray> roleNames() const override;
@@ -23,13 +37,29 @@ public:
     Q_INVOKABLE void move(int from, int to);
     Q_INVOKABLE void save();
 
+    bool isLoaded() const;
     bool onlyFavorites() const;
     void setOnlyFavorites(bool onlyFavorites);
+    QDateTime programsStart() const;
+    void setProgramsStart(const QDateTime &start);
+    QDateTime programsStop() const;
+    void setProgramsStop(const QDateTime &stop);
+
+Q_SIGNALS:
+    void loadedChanged();
+    void programsRangeChanged();
 
 private:
-    void loadChannel(int index) const;
+    void reload(); // applies the changes only
+    static bool isSame(const ChannelFactory::Entry &l, const ChannelFactory::Entry &r);
+    Channel *channel(int index) const;
+    void updateProgramsRange();
 
-    mutable QVector<Channel *> m_channels;
+    mutable QVector<Channel *> m_channels; // nullptr if not created yet
     bool m_onlyFavorites;
+    bool m_loaded = false;
+    QDateTime m_programsStart;
+    QDateTime m_programsStop;
+    QTimer m_programsRangeTimer; // start and stop change together (one reload)
     ChannelFactory m_channelFactory;
 };
@@ -1,22 +1,39 @@
 #include "channelsproxymodel.h"
 
-#include "channel.h"
-#include "database.h"
+#include "channelfactory.h"
+#include "channelsearchindex.h"
+#include "channelsmodel.h"
+
+#include <QBitArray>
 
 ChannelsProxyModel::ChannelsProxyModel(QObject *parent)
     : QSortFilterProxyModel(parent)
     , m_onlyFavorites(false)
     , m_country("")
+    , m_countryIndex(-1)
 {
-    connect(&Database::instance(), &Database::channelDetailsUpdated, this, [this]() {
-        invalidateFilter();
-    });
+    // favorite changes are signaled by dataChanged() of the ChannelsModel (dynamicSortFilter)
 }
 
 ChannelsProxyModel::~ChannelsProxyModel()
 {
 }
 
+void ChannelsProxyModel::setSourceModel(QAbstractItemModel *model)
+{
+    if (sourceModel()) {
+        disconnect(sourceModel(), &QAbstractItemModel::rowsInserted, this, &ChannelsProxyModel::updateSearchMatches);
+        disconnect(sourceModel(), &QAbstractItemModel::modelReset, this, &ChannelsProxyModel::updateSearchMatches);
+    }
+    QSortFilterProxyModel::setSourceModel(model);
+
+    // after the connections of the base class: the new rows were filtered with the old matches already
+    if (model) {
+        connect(model, &QAbstractItemModel::rowsInserted, this, &ChannelsProxyModel::updateSearchMatches);
+        connect(model, &QAbstractItemModel::modelReset, this, &ChannelsProxyModel::updateSearchMatches);
+    }
+}
+
 bool ChannelsProxyModel::onlyFavorites() const
 {
     return m_onlyFavorites;
@@ -40,11 +57,36 @@ void ChannelsProxyModel::setCountry(const QString &country)
 {
     if (m_country.value() != country) {
         m_country = CountryId(country);
+        m_countryIndex = country.isEmpty() ? -1 : ChannelFactory::countryIndex(m_country);
         invalidateFilter();
         Q_EMIT countryChanged();
     }
 }
 
+const QString &ChannelsProxyModel::search() const
+{
+    return m_search;
+}
+
+void ChannelsProxyModel::setSearch(const QString &search)
+{
+    if (m_search != search) {
+        m_search = search;
+        m_searching = !ChannelSearchIndex::normalized(search).isEmpty();
+        m_searchMatches = m_searching ? ChannelSearchIndex::instance().match(search) : QBitArray();
+        invalidateFilter();
+        Q_EMIT searchChanged();
+    }
+}
+
+void ChannelsProxyModel::updateSearchMatches()
+{
+    if (m_searching) {
+        m_searchMatches = ChannelSearchIndex::instance().match(m_search);
+        invalidateFilter();
+    }
+}
+
 bool ChannelsProxyModel::filterAcceptsRow(int source_row, const QModelIndex &source_parent) const
 {
     const auto idx = sourceModel()->index(source_row, 0, source_parent);
@@ -54,15 +96,23 @@ bool ChannelsProxyModel::filterAcceptsRow(int source_row, const QModelIndex &sou
     }
 
     // no filter
-    if (!m_onlyFavorites && m_country.value().isEmpty()) {
+    if (!m_onlyFavorites && m_countryIndex < 0 && !m_searching) {
         return true;
     }
 
-    // at least one filter
-    auto channel = idx.data(0).value<Channel *>();
-
-    const bool onlyFavoritesMatches = !m_onlyFavorites || channel->favorite();
-    const bool countryMatches = m_country.value().isEmpty() || channel->countries().contains(m_country.value());
-
-    return onlyFavoritesMatches && countryMatches;
+    // at least one filter (plain data roles, no Channel is created)
+    if (m_onlyFavorites && !idx.data(ChannelsModel::FavoriteRole).toBool()) {
+        return false;
+    }
+    if (m_countryIndex >= 0) {
+        const QBitArray countries = idx.data(ChannelsModel::CountriesRole).toBitArray();
+        if (m_countryIndex >= countries.size() || !countries.testBit(m_countryIndex)) {
+            return false;
+        }
+    }
+    if (m_searching) {
+        const int key = idx.data(ChannelsModel::SearchKeyRole).toInt();
+        return key >= 0 && key < m_searchMatches.size() && m_searchMatches.testBit(key);
+    }
+    return true;
 }
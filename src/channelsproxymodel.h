@@ -4,17 +4,21 @@
 
 #include "types.h"
 
+#include <QBitArray>
+
 class ChannelsProxyModel : public QSortFilterProxyModel
 {
     Q_OBJECT
 
     Q_PROPERTY(bool onlyFavorites READ onlyFavorites WRITE setOnlyFavorites NOTIFY onlyFavoritesChanged)
     Q_PROPERTY(QString country READ country WRITE setCountry NOTIFY countryChanged)
+    Q_PROPERTY(QString search READ search WRITE setSearch NOTIFY searchChanged) // part of the channel name
 
 public:
     explicit ChannelsProxyModel(QObject *parent = nullptr);
     ~ChannelsProxyModel() override;
 
+    void setSourceModel(QAbstractItemModel *model) override;
     bool filterAcceptsRow(int source_row, const QModelIndex &source_parent) const override;
 
     bool onlyFavorites() const;
@@ -23,11 +27,21 @@ public:
     const QString &country() const;
     void setCountry(const QString &country);
 
+    const QString &search() const;
+    void setSearch(const QString &search);
+
 Q_SIGNALS:
     void onlyFavoritesChanged();
     void countryChanged();
+    void searchChanged();
 
 private:
+    void updateSearchMatches(); // new channels may match the current search
+
     bool m_onlyFavorites;
     CountryId m_country;
+    int m_countryIndex; // bit in the countries of the channels, < 0 if all countries
+    QString m_search;
+    bool m_searching = false;
+    QBitArray m_searchMatches; // search keys of the matching channels
 };
@@ -3,6 +3,7 @@
 #include "country.h"
 #include "database.h"
 #include "fetcher.h"
+#include "startup.h"
 #include "types.h"
 
 #include <QDebug>
@@ -10,6 +11,13 @@
 CountriesModel::CountriesModel(QObject *parent)
     : QAbstractListModel(parent)
 {
+    // empty until the database is open (see Startup)
+    Startup::instance().whenDatabaseReady(this, [this]() {
+        beginResetModel();
+        m_countryFactory.load();
+        endResetModel();
+    });
+
     connect(&Database::instance(), &Database::countryAdded, this, [this]() {
         m_countryFactory.load();
         beginInsertRows(QModelIndex(), rowCount(QModelIndex()) - 1, rowCount(QModelIndex()) - 1);
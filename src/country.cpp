@@ -2,7 +2,7 @@
 
 #include "channelsmodel.h"
 #include "database.h"
-#include "fetcher.h"
+#include "eventhub.h"
 
 #include <QDebug>
 
@@ -10,21 +10,16 @@ Country::Country(CountryData data)
     : QObject(nullptr)
     , m_data(data)
 {
-    connect(&Fetcher::instance(), &Fetcher::startedFetchingCountry, this, [this](const CountryId &id) {
-        if (id == m_data.m_id) {
-            setRefreshing(true);
-        }
+    EventHub &eventHub = EventHub::instance();
+    eventHub.countryFetchStarted().subscribe(m_data.m_id, this, [this]() {
+        setRefreshing(true);
     });
-    connect(&Fetcher::instance(), &Fetcher::countryUpdated, this, [this](const CountryId &id) {
-        if (id == m_data.m_id) {
-            setRefreshing(false);
-        }
+    eventHub.countryUpdated().subscribe(m_data.m_id, this, [this]() {
+        setRefreshing(false);
     });
-    connect(&Fetcher::instance(), &Fetcher::errorFetchingCountry, this, [this](const CountryId &id, const Error &error) {
-        if (id == m_data.m_id) {
-            setError(error);
-            setRefreshing(false);
-        }
+    eventHub.countryFetchFailed().subscribe(m_data.m_id, this, [this](const Error &error) {
+        setError(error);
+        setRefreshing(false);
     });
 
     m_channels = new ChannelsModel(this);
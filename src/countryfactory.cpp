@@ -9,7 +9,7 @@
 CountryFactory::CountryFactory()
     : QObject(nullptr)
 {
-    m_countries = Database::instance().countries();
+    // loaded by the model as soon as the database is ready
 }
 
 size_t CountryFactory::count() const
@@ -2,9 +2,11 @@
 
 #include "TellySkoutSettings.h"
 #include "fetcher.h"
+#include "tracer.h"
 
 #include <QDateTime>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QSqlDatabase>
 #include <QSqlError>
 #include <QStandardPaths>
@@ -16,6 +18,16 @@
 
 Database::Database()
 {
+}
+
+void Database::open()
+{
+    if (m_open) {
+        return;
+    }
+    m_open = true;
+    TRACE_FUNCTION("database");
+
     QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"));
     const QString databasePath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
     QDir(databasePath).mkpath(databasePath);
@@ -26,8 +38,6 @@ Database::Database()
         qCritical() << "Failed to create database";
     }
 
-    cleanup();
-
     // speed up database (especially for slow persistent memory like on the PinePhone)
     execute(QStringLiteral("PRAGMA synchronous = OFF;"));
     execute(QStringLiteral("PRAGMA journal_mode = WAL;")); // TODO: or MEMORY?
@@ -49,6 +59,8 @@ Database::Database()
 
     m_addCountryChannelQuery = new QSqlQuery(db);
     m_addCountryChannelQuery->prepare(QStringLiteral("INSERT OR IGNORE INTO CountryChannels VALUES (:id, :country, :channel);"));
+    m_channelCountriesQuery = new QSqlQuery(db);
+    m_channelCountriesQuery->prepare(QStringLiteral("SELECT channel, country FROM CountryChannels;"));
 
     m_addFavoriteQuery = new QSqlQuery(db);
     m_addFavoriteQuery->prepare(QStringLiteral("INSERT INTO Favorites VALUES ((SELECT COUNT() FROM Favorites) + 1, :channel);"));
@@ -63,6 +75,13 @@ Database::Database()
     m_channelQuery = new QSqlQuery(db);
     m_channelQuery->prepare(QStringLiteral("SELECT * FROM Channels WHERE id=:channelId;"));
 
+    m_addChannelProviderQuery = new QSqlQuery(db);
+    m_addChannelProviderQuery->prepare(QStringLiteral("INSERT OR IGNORE INTO ChannelProviders VALUES (:channel, :provider, :providerChannel);"));
+    m_channelProvidersQuery = new QSqlQuery(db);
+    m_channelProvidersQuery->prepare(QStringLiteral("SELECT * FROM ChannelProviders WHERE channel=:channel;"));
+    m_nativeChannelProvidersQuery = new QSqlQuery(db);
+    m_nativeChannelProvidersQuery->prepare(QStringLiteral("SELECT channel, provider FROM ChannelProviders WHERE channel=providerChannel;"));
+
     m_removeFavoriteQuery = new QSqlQuery(db);
     m_removeFavoriteQuery->prepare(QStringLiteral("DELETE FROM Favorites WHERE channel=:channel;"));
     m_clearFavoritesQuery = new QSqlQuery(db);
@@ -79,6 +98,8 @@ Database::Database()
         "INSERT OR IGNORE INTO Programs VALUES (:id, :url, :channel, :start, :stop, :title, :subtitle, :description, :descriptionFetched, :category);"));
     m_updateProgramDescriptionQuery = new QSqlQuery(db);
     m_updateProgramDescriptionQuery->prepare(QStringLiteral("UPDATE Programs SET description=:description, descriptionFetched=TRUE WHERE id=:id;"));
+    m_programDescriptionQuery = new QSqlQuery(db);
+    m_programDescriptionQuery->prepare(QStringLiteral("SELECT description FROM Programs WHERE id=:id;"));
     m_programExistsQuery = new QSqlQuery(db);
     m_programExistsQuery->prepare(QStringLiteral("SELECT COUNT () FROM Programs WHERE channel=:channel AND stop>=:lastTime;"));
     m_programCountQuery = new QSqlQuery(db);
@@ -87,6 +108,13 @@ Database::Database()
     m_programsQuery->prepare(QStringLiteral("SELECT * FROM Programs ORDER BY channel, start;"));
     m_programsPerChannelQuery = new QSqlQuery(db);
     m_programsPerChannelQuery->prepare(QStringLiteral("SELECT * FROM Programs WHERE channel=:channel ORDER BY start;"));
+    m_programsPerChannelInRangeQuery = new QSqlQuery(db);
+    m_programsPerChannelInRangeQuery->prepare(QStringLiteral("SELECT * FROM Programs WHERE channel=:channel AND start<:to AND stop>:from ORDER BY start;"));
+    m_favoriteProgramsWithoutDescriptionQuery = new QSqlQuery(db);
+    m_favoriteProgramsWithoutDescriptionQuery->prepare(
+        QStringLiteral("SELECT Programs.id, Programs.url, Programs.channel, Programs.start, Programs.stop FROM Programs INNER JOIN Favorites ON "
+                       "Programs.channel=Favorites.channel WHERE Programs.descriptionFetched=FALSE AND Programs.url!='' AND Programs.stop>:from AND "
+                       "Programs.start<:to ORDER BY Programs.start;"));
 }
 
 Database::~Database()
@@ -98,6 +126,7 @@ Database::~Database()
     delete m_countriesPerChannelQuery;
 
     delete m_addCountryChannelQuery;
+    delete m_channelCountriesQuery;
 
     delete m_addChannelQuery;
     delete m_channelCountQuery;
@@ -105,6 +134,10 @@ Database::~Database()
     delete m_channelsQuery;
     delete m_channelQuery;
 
+    delete m_addChannelProviderQuery;
+    delete m_channelProvidersQuery;
+    delete m_nativeChannelProvidersQuery;
+
     delete m_addFavoriteQuery;
     delete m_removeFavoriteQuery;
     delete m_clearFavoritesQuery;
@@ -114,14 +147,18 @@ Database::~Database()
 
     delete m_addProgramQuery;
     delete m_updateProgramDescriptionQuery;
+    delete m_programDescriptionQuery;
     delete m_programExistsQuery;
     delete m_programCountQuery;
     delete m_programsQuery;
     delete m_programsPerChannelQuery;
+    delete m_programsPerChannelInRangeQuery;
+    delete m_favoriteProgramsWithoutDescriptionQuery;
 }
 
 bool Database::createTables()
 {
+    TRACE_FUNCTION("database");
     qDebug() << "Create DB tables";
     TRUE_OR_RETURN(execute(QStringLiteral("CREATE TABLE IF NOT EXISTS Countries (id TEXT UNIQUE, name TEXT, url TEXT);")));
     TRUE_OR_RETURN(execute(QStringLiteral("CREATE TABLE IF NOT EXISTS Channels (id TEXT UNIQUE, name TEXT, url TEXT, image TEXT);")));
@@ -130,6 +167,11 @@ bool Database::createTables()
         QStringLiteral("CREATE TABLE IF NOT EXISTS Programs (id TEXT UNIQUE, url TEXT, channel TEXT, start INTEGER, stop INTEGER, title TEXT, subtitle TEXT, "
                        "description TEXT, descriptionFetched INTEGER, category TEXT);")));
     TRUE_OR_RETURN(execute(QStringLiteral("CREATE TABLE IF NOT EXISTS Favorites (id INTEGER UNIQUE, channel TEXT UNIQUE);")));
+    TRUE_OR_RETURN(
+        execute(QStringLiteral("CREATE TABLE IF NOT EXISTS ChannelProviders (channel TEXT, provider TEXT, providerChannel TEXT, UNIQUE(channel, provider));")));
+
+    // programs are loaded per channel
+    TRUE_OR_RETURN(execute(QStringLiteral("CREATE INDEX IF NOT EXISTS ProgramsChannelStart ON Programs (channel, start);")));
 
     TRUE_OR_RETURN(execute(QStringLiteral("PRAGMA user_version = 1;")));
     return true;
@@ -144,7 +186,12 @@ bool Database::execute(const QString &query)
 
 bool Database::execute(QSqlQuery &query)
 {
-    if (!query.exec()) {
+    QElapsedTimer timer;
+    timer.start();
+    const bool ok = query.exec();
+    m_busyTime += timer.nsecsElapsed() / 1000;
+
+    if (!ok) {
         qWarning() << "Failed to execute SQL Query";
         qWarning() << query.lastQuery();
         qWarning() << query.lastError();
@@ -153,8 +200,22 @@ bool Database::execute(QSqlQuery &query)
     return true;
 }
 
+void Database::commit()
+{
+    QElapsedTimer timer;
+    timer.start();
+    QSqlDatabase::database().commit();
+    m_busyTime += timer.nsecsElapsed() / 1000;
+}
+
+qint64 Database::busyTime() const
+{
+    return m_busyTime;
+}
+
 int Database::version()
 {
+    TRACE_FUNCTION("database");
     QSqlQuery query;
     query.prepare(QStringLiteral("PRAGMA user_version;"));
     execute(query);
@@ -173,6 +234,7 @@ int Database::version()
 
 void Database::cleanup()
 {
+    TRACE_FUNCTION("database");
     const TellySkoutSettings settings;
     const unsigned int days = settings.deleteProgramAfter();
 
@@ -188,6 +250,7 @@ void Database::cleanup()
 
 void Database::addCountry(const CountryId &id, const QString &name, const QString &url)
 {
+    TRACE_FUNCTION("database");
     if (!countryExists(id)) {
         qDebug() << "Add country" << name;
         m_addCountryQuery->bindValue(QStringLiteral(":id"), id.value());
@@ -201,6 +264,7 @@ void Database::addCountry(const CountryId &id, const QString &name, const QStrin
 
 size_t Database::countryCount()
 {
+    TRACE_FUNCTION("database");
     execute(*m_countryCountQuery);
     if (!m_countryCountQuery->next()) {
         qWarning() << "Failed to query country count";
@@ -211,6 +275,7 @@ size_t Database::countryCount()
 
 bool Database::countryExists(const CountryId &id)
 {
+    TRACE_FUNCTION("database");
     m_countryExistsQuery->bindValue(QStringLiteral(":id"), id.value());
     execute(*m_countryExistsQuery);
     m_countryExistsQuery->next();
@@ -220,6 +285,7 @@ bool Database::countryExists(const CountryId &id)
 
 QVector<CountryData> Database::countries()
 {
+    TRACE_FUNCTION("database");
     QVector<CountryData> countries;
 
     execute(*m_countriesQuery);
@@ -235,6 +301,7 @@ QVector<CountryData> Database::countries()
 
 QVector<CountryData> Database::countries(const ChannelId &channelId)
 {
+    TRACE_FUNCTION("database");
     QVector<CountryData> countries;
 
     m_countriesPerChannelQuery->bindValue(QStringLiteral(":channel"), channelId.value());
@@ -249,8 +316,21 @@ QVector<CountryData> Database::countries(const ChannelId &channelId)
     return countries;
 }
 
+QMultiHash<ChannelId, CountryId> Database::channelCountries()
+{
+    TRACE_FUNCTION("database");
+    QMultiHash<ChannelId, CountryId> channelCountries;
+
+    execute(*m_channelCountriesQuery);
+    while (m_channelCountriesQuery->next()) {
+        channelCountries.insert(ChannelId(m_channelCountriesQuery->value(0).toString()), CountryId(m_channelCountriesQuery->value(1).toString()));
+    }
+    return channelCountries;
+}
+
 void Database::addChannel(const ChannelData &data, const CountryId &country)
 {
+    TRACE_FUNCTION("database");
     if (!channelExists(data.m_id)) {
         qDebug() << "Add channel" << data.m_name;
 
@@ -276,8 +356,22 @@ void Database::addChannel(const ChannelData &data, const CountryId &country)
     }
 }
 
+void Database::addChannels(const QVector<ChannelData> &channels, const CountryId &country)
+{
+    TRACE_FUNCTION("database");
+    QSqlDatabase::database().transaction();
+
+    for (int i = 0; i < channels.length(); i++) {
+        const ChannelData &data = channels.at(i);
+        addChannel(data, country);
+    }
+
+    commit();
+}
+
 size_t Database::channelCount()
 {
+    TRACE_FUNCTION("database");
     execute(*m_channelCountQuery);
     if (!m_channelCountQuery->next()) {
         qWarning() << "Failed to query channel count";
@@ -288,6 +382,7 @@ size_t Database::channelCount()
 
 bool Database::channelExists(const ChannelId &id)
 {
+    TRACE_FUNCTION("database");
     m_channelExistsQuery->bindValue(QStringLiteral(":id"), id.value());
     execute(*m_channelExistsQuery);
     m_channelExistsQuery->next();
@@ -297,6 +392,7 @@ bool Database::channelExists(const ChannelId &id)
 
 QVector<ChannelData> Database::channels(bool onlyFavorites)
 {
+    TRACE_FUNCTION("database");
     QVector<ChannelData> channels;
 
     if (onlyFavorites) {
@@ -306,7 +402,7 @@ QVector<ChannelData> Database::channels(bool onlyFavorites)
         for (int i = 0; i < favoriteIds.size(); ++i) {
             channels.append(channel(favoriteIds.at(i)));
         }
-        QSqlDatabase::database().commit();
+        commit();
     } else {
         execute(*m_channelsQuery);
         while (m_channelsQuery->next()) {
@@ -323,6 +419,7 @@ QVector<ChannelData> Database::channels(bool onlyFavorites)
 
 ChannelData Database::channel(const ChannelId &channelId)
 {
+    TRACE_FUNCTION("database");
     ChannelData data;
     data.m_id = channelId;
 
@@ -339,8 +436,48 @@ ChannelData Database::channel(const ChannelId &channelId)
     return data;
 }
 
+void Database::addChannelProvider(const ChannelId &channelId, const QString &provider, const ChannelId &providerChannelId)
+{
+    TRACE_FUNCTION("database");
+    m_addChannelProviderQuery->bindValue(QStringLiteral(":channel"), channelId.value());
+    m_addChannelProviderQuery->bindValue(QStringLiteral(":provider"), provider);
+    m_addChannelProviderQuery->bindValue(QStringLiteral(":providerChannel"), providerChannelId.value());
+    execute(*m_addChannelProviderQuery);
+}
+
+QVector<ChannelProviderData> Database::channelProviders(const ChannelId &channelId)
+{
+    TRACE_FUNCTION("database");
+    QVector<ChannelProviderData> providers;
+
+    m_channelProvidersQuery->bindValue(QStringLiteral(":channel"), channelId.value());
+    execute(*m_channelProvidersQuery);
+    while (m_channelProvidersQuery->next()) {
+        ChannelProviderData data;
+        data.m_channelId = ChannelId(m_channelProvidersQuery->value(QStringLiteral("channel")).toString());
+        data.m_provider = m_channelProvidersQuery->value(QStringLiteral("provider")).toString();
+        data.m_providerChannelId = ChannelId(m_channelProvidersQuery->value(QStringLiteral("providerChannel")).toString());
+        providers.append(data);
+    }
+    return providers;
+}
+
+QMap<ChannelId, QString> Database::nativeChannelProviders()
+{
+    TRACE_FUNCTION("database");
+    QMap<ChannelId, QString> providers;
+
+    execute(*m_nativeChannelProvidersQuery);
+    while (m_nativeChannelProvidersQuery->next()) {
+        const ChannelId channelId = ChannelId(m_nativeChannelProvidersQuery->value(QStringLiteral("channel")).toString());
+        providers.insert(channelId, m_nativeChannelProvidersQuery->value(QStringLiteral("provider")).toString());
+    }
+    return providers;
+}
+
 void Database::addFavorite(const ChannelId &channelId)
 {
+    TRACE_FUNCTION("database");
     m_addFavoriteQuery->bindValue(QStringLiteral(":channel"), channelId.value());
     execute(*m_addFavoriteQuery);
 
@@ -349,6 +486,7 @@ void Database::addFavorite(const ChannelId &channelId)
 
 void Database::removeFavorite(const ChannelId &channelId)
 {
+    TRACE_FUNCTION("database");
     m_removeFavoriteQuery->bindValue(QStringLiteral(":channel"), channelId.value());
     execute(*m_removeFavoriteQuery);
 
@@ -357,6 +495,7 @@ void Database::removeFavorite(const ChannelId &channelId)
 
 void Database::sortFavorites(const QVector<ChannelId> &newOrder)
 {
+    TRACE_FUNCTION("database");
     QSqlDatabase::database().transaction();
     // do not use clearFavorites() and addFavorite() to avoid unneccesary signals (and therefore updates)
     execute(*m_clearFavoritesQuery);
@@ -364,13 +503,14 @@ void Database::sortFavorites(const QVector<ChannelId> &newOrder)
         m_addFavoriteQuery->bindValue(QStringLiteral(":channel"), channelId.value());
         execute(*m_addFavoriteQuery);
     }
-    QSqlDatabase::database().commit();
+    commit();
 
     Q_EMIT favoritesUpdated();
 }
 
 void Database::clearFavorites()
 {
+    TRACE_FUNCTION("database");
     const QVector<ChannelId> favoriteChannelIds = favorites();
 
     execute(*m_clearFavoritesQuery);
@@ -382,6 +522,7 @@ void Database::clearFavorites()
 
 size_t Database::favoriteCount()
 {
+    TRACE_FUNCTION("database");
     execute(*m_favoriteCountQuery);
     if (!m_favoriteCountQuery->next()) {
         qWarning() << "Failed to query favorite count";
@@ -392,6 +533,7 @@ size_t Database::favoriteCount()
 
 QVector<ChannelId> Database::favorites()
 {
+    TRACE_FUNCTION("database");
     QVector<ChannelId> favorites;
 
     execute(*m_favoritesQuery);
@@ -404,6 +546,7 @@ QVector<ChannelId> Database::favorites()
 
 bool Database::isFavorite(const ChannelId &channelId)
 {
+    TRACE_FUNCTION("database");
     m_isFavoriteQuery->bindValue(QStringLiteral(":channel"), channelId.value());
     execute(*m_isFavoriteQuery);
     m_isFavoriteQuery->next();
@@ -412,6 +555,7 @@ bool Database::isFavorite(const ChannelId &channelId)
 
 void Database::addProgram(const ProgramData &data)
 {
+    TRACE_FUNCTION("database");
     m_addProgramQuery->bindValue(QStringLiteral(":id"), data.m_id.value());
     m_addProgramQuery->bindValue(QStringLiteral(":url"), data.m_url);
     m_addProgramQuery->bindValue(QStringLiteral(":channel"), data.m_channelId.value());
@@ -428,14 +572,39 @@ void Database::addProgram(const ProgramData &data)
 
 void Database::updateProgramDescription(const ProgramId &id, const QString &description)
 {
+    TRACE_FUNCTION("database");
     m_updateProgramDescriptionQuery->bindValue(QStringLiteral(":id"), id.value());
     m_updateProgramDescriptionQuery->bindValue(QStringLiteral(":description"), description);
 
     execute(*m_updateProgramDescriptionQuery);
 }
 
+void Database::updateProgramDescriptions(const QHash<ProgramId, QString> &descriptions)
+{
+    TRACE_FUNCTION("database");
+    QSqlDatabase::database().transaction();
+
+    for (auto it = descriptions.constBegin(); it != descriptions.constEnd(); ++it) {
+        updateProgramDescription(it.key(), it.value());
+    }
+
+    commit();
+}
+
+QString Database::programDescription(const ProgramId &id)
+{
+    TRACE_FUNCTION("database");
+    m_programDescriptionQuery->bindValue(QStringLiteral(":id"), id.value());
+    execute(*m_programDescriptionQuery);
+    if (!m_programDescriptionQuery->next()) {
+        return QString();
+    }
+    return m_programDescriptionQuery->value(0).toString();
+}
+
 void Database::addPrograms(const QVector<ProgramData> &programs)
 {
+    TRACE_FUNCTION("database");
     QSqlDatabase::database().transaction();
 
     for (int i = 0; i < programs.length(); i++) {
@@ -443,11 +612,12 @@ void Database::addPrograms(const QVector<ProgramData> &programs)
         addProgram(data);
     }
 
-    QSqlDatabase::database().commit();
+    commit();
 }
 
 bool Database::programExists(const ChannelId &channelId, qint64 lastTime)
 {
+    TRACE_FUNCTION("database");
     m_programExistsQuery->bindValue(QStringLiteral(":channel"), channelId.value());
     m_programExistsQuery->bindValue(QStringLiteral(":lastTime"), lastTime);
     execute(*m_programExistsQuery);
@@ -458,6 +628,7 @@ bool Database::programExists(const ChannelId &channelId, qint64 lastTime)
 
 size_t Database::programCount(const ChannelId &channelId)
 {
+    TRACE_FUNCTION("database");
     m_programCountQuery->bindValue(QStringLiteral(":channel"), channelId.value());
     execute(*m_programCountQuery);
     if (!m_programCountQuery->next()) {
@@ -469,6 +640,7 @@ size_t Database::programCount(const ChannelId &channelId)
 
 QMap<ChannelId, QVector<ProgramData>> Database::programs()
 {
+    TRACE_FUNCTION("database");
     QMap<ChannelId, QVector<ProgramData>> programs;
 
     execute(*m_programsQuery);
@@ -499,23 +671,60 @@ QMap<ChannelId, QVector<ProgramData>> Database::programs()
 
 QVector<ProgramData> Database::programs(const ChannelId &channelId)
 {
-    QVector<ProgramData> programs;
-
+    TRACE_FUNCTION("database");
     m_programsPerChannelQuery->bindValue(QStringLiteral(":channel"), channelId.value());
     execute(*m_programsPerChannelQuery);
+    return programs(*m_programsPerChannelQuery);
+}
+
+QVector<ProgramData> Database::programs(const ChannelId &channelId, qint64 from, qint64 to)
+{
+    TRACE_FUNCTION("database");
+    m_programsPerChannelInRangeQuery->bindValue(QStringLiteral(":channel"), channelId.value());
+    m_programsPerChannelInRangeQuery->bindValue(QStringLiteral(":from"), from);
+    m_programsPerChannelInRangeQuery->bindValue(QStringLiteral(":to"), to);
+    execute(*m_programsPerChannelInRangeQuery);
+    return programs(*m_programsPerChannelInRangeQuery);
+}
+
+QVector<ProgramData> Database::programs(QSqlQuery &query)
+{
+    QVector<ProgramData> programs;
+    while (query.next()) {
+        ProgramData data;
+        data.m_id = ProgramId(query.value(QStringLiteral("id")).toString());
+        data.m_url = query.value(QStringLiteral("url")).toString();
+        data.m_channelId = ChannelId(query.value(QStringLiteral("channel")).toString());
+        data.m_startTime.setSecsSinceEpoch(query.value(QStringLiteral("start")).toInt());
+        data.m_stopTime.setSecsSinceEpoch(query.value(QStringLiteral("stop")).toInt());
+        data.m_title = query.value(QStringLiteral("title")).toString();
+        data.m_subtitle = query.value(QStringLiteral("subtitle")).toString();
+        data.m_description = query.value(QStringLiteral("description")).toString();
+        data.m_descriptionFetched = query.value(QStringLiteral("descriptionFetched")).toBool();
+        data.m_category = query.value(QStringLiteral("category")).toString();
+
+        programs.push_back(data);
+    }
+    return programs;
+}
+
+QVector<ProgramData> Database::favoriteProgramsWithoutDescription(qint64 from, qint64 to)
+{
+    TRACE_FUNCTION("database");
+    QVector<ProgramData> programs;
+
+    m_favoriteProgramsWithoutDescriptionQuery->bindValue(QStringLiteral(":from"), from);
+    m_favoriteProgramsWithoutDescriptionQuery->bindValue(QStringLiteral(":to"), to);
+    execute(*m_favoriteProgramsWithoutDescriptionQuery);
 
-    while (m_programsPerChannelQuery->next()) {
+    while (m_favoriteProgramsWithoutDescriptionQuery->next()) {
         ProgramData data;
-        data.m_id = ProgramId(m_programsPerChannelQuery->value(QStringLiteral("id")).toString());
-        data.m_url = m_programsPerChannelQuery->value(QStringLiteral("url")).toString();
-        data.m_channelId = ChannelId(m_programsPerChannelQuery->value(QStringLiteral("channel")).toString());
-        data.m_startTime.setSecsSinceEpoch(m_programsPerChannelQuery->value(QStringLiteral("start")).toInt());
-        data.m_stopTime.setSecsSinceEpoch(m_programsPerChannelQuery->value(QStringLiteral("stop")).toInt());
-        data.m_title = m_programsPerChannelQuery->value(QStringLiteral("title")).toString();
-        data.m_subtitle = m_programsPerChannelQuery->value(QStringLiteral("subtitle")).toString();
-        data.m_description = m_programsPerChannelQuery->value(QStringLiteral("description")).toString();
-        data.m_descriptionFetched = m_programsPerChannelQuery->value(QStringLiteral("descriptionFetched")).toBool();
-        data.m_category = m_programsPerChannelQuery->value(QStringLiteral("category")).toString();
+        data.m_id = ProgramId(m_favoriteProgramsWithoutDescriptionQuery->value(QStringLiteral("id")).toString());
+        data.m_url = m_favoriteProgramsWithoutDescriptionQuery->value(QStringLiteral("url")).toString();
+        data.m_channelId = ChannelId(m_favoriteProgramsWithoutDescriptionQuery->value(QStringLiteral("channel")).toString());
+        data.m_startTime.setSecsSinceEpoch(m_favoriteProgramsWithoutDescriptionQuery->value(QStringLiteral("start")).toInt());
+        data.m_stopTime.setSecsSinceEpoch(m_favoriteProgramsWithoutDescriptionQuery->value(QStringLiteral("stop")).toInt());
+        data.m_descriptionFetched = false;
 
         programs.push_back(data);
     }
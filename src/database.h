@@ -3,11 +3,14 @@
 #include <QObject>
 
 #include "channeldata.h"
+#include "channelproviderdata.h"
 #include "countrydata.h"
 #include "programdata.h"
 #include "types.h"
 
+#include <QHash>
 #include <QMap>
+#include <QMultiHash>
 #include <QSqlQuery>
 #include <QString>
 #include <QVector>
@@ -24,21 +27,32 @@ public:
         static Database _instance;
         return _instance;
     }
+    // creates the tables and prepares the queries, must be called before any other query (see Startup)
+    void open();
+    void cleanup(); // deletes old programs
+
     bool execute(QSqlQuery &query);
     bool execute(const QString &query);
+    qint64 busyTime() const; // [us] spent executing queries and commits (e.g. for benchmarks)
 
     void addCountry(const CountryId &id, const QString &name, const QString &url);
     size_t countryCount();
     bool countryExists(const CountryId &id);
     QVector<CountryData> countries();
     QVector<CountryData> countries(const ChannelId &channelId);
+    QMultiHash<ChannelId, CountryId> channelCountries(); // all channels at once
 
     void addChannel(const ChannelData &data, const CountryId &country);
+    void addChannels(const QVector<ChannelData> &channels, const CountryId &country);
     size_t channelCount();
     bool channelExists(const ChannelId &id);
     QVector<ChannelData> channels(bool onlyFavorites);
     ChannelData channel(const ChannelId &channelId);
 
+    void addChannelProvider(const ChannelId &channelId, const QString &provider, const ChannelId &providerChannelId);
+    QVector<ChannelProviderData> channelProviders(const ChannelId &channelId);
+    QMap<ChannelId, QString> nativeChannelProviders(); // channel -> provider which added it
+
     void addFavorite(const ChannelId &channelId);
     void removeFavorite(const ChannelId &channelId);
     void sortFavorites(const QVector<ChannelId> &newOrder); // newOrder must contain same channel IDs as existing favorites
@@ -49,11 +63,15 @@ public:
 
     void addProgram(const ProgramData &data);
     void updateProgramDescription(const ProgramId &id, const QString &description);
+    void updateProgramDescriptions(const QHash<ProgramId, QString> &descriptions);
+    QString programDescription(const ProgramId &id);
     void addPrograms(const QVector<ProgramData> &programs);
     bool programExists(const ChannelId &channelId, qint64 lastTime);
     size_t programCount(const ChannelId &channelId);
     QMap<ChannelId, QVector<ProgramData>> programs();
     QVector<ProgramData> programs(const ChannelId &channelId);
+    QVector<ProgramData> programs(const ChannelId &channelId, qint64 from, qint64 to); // running in [from, to)
+    QVector<ProgramData> favoriteProgramsWithoutDescription(qint64 from, qint64 to); // running in [from, to]
 
 Q_SIGNALS:
     void countryAdded(const CountryId &id);
@@ -66,33 +84,45 @@ private:
     ~Database();
     int version();
     bool createTables();
-    void cleanup();
-
-    QSqlQuery *m_addCountryQuery;
-    QSqlQuery *m_countryCountQuery;
-    QSqlQuery *m_countryExistsQuery;
-    QSqlQuery *m_countriesQuery;
-    QSqlQuery *m_countriesPerChannelQuery;
-
-    QSqlQuery *m_addCountryChannelQuery;
-
-    QSqlQuery *m_addChannelQuery;
-    QSqlQuery *m_channelCountQuery;
-    QSqlQuery *m_channelExistsQuery;
-    QSqlQuery *m_channelsQuery;
-    QSqlQuery *m_channelQuery;
-
-    QSqlQuery *m_addFavoriteQuery;
-    QSqlQuery *m_removeFavoriteQuery;
-    QSqlQuery *m_clearFavoritesQuery;
-    QSqlQuery *m_favoriteCountQuery;
-    QSqlQuery *m_favoritesQuery;
-    QSqlQuery *m_isFavoriteQuery;
-
-    QSqlQuery *m_addProgramQuery;
-    QSqlQuery *m_updateProgramDescriptionQuery;
-    QSqlQuery *m_programExistsQuery;
-    QSqlQuery *m_programCountQuery;
-    QSqlQuery *m_programsQuery;
-    QSqlQuery *m_programsPerChannelQuery;
+    void commit();
+    static QVector<ProgramData> programs(QSqlQuery &query); // rows of an executed query
+
+    QSqlQuery *m_addCountryQuery = nullptr;
+    QSqlQuery *m_countryCountQuery = nullptr;
+    QSqlQuery *m_countryExistsQuery = nullptr;
+    QSqlQuery *m_countriesQuery = nullptr;
+    QSqlQuery *m_countriesPerChannelQuery = nullptr;
+
+    QSqlQuery *m_addCountryChannelQuery = nullptr;
+    QSqlQuery *m_channelCountriesQuery = nullptr;
+
+    QSqlQuery *m_addChannelQuery = nullptr;
+    QSqlQuery *m_channelCountQuery = nullptr;
+    QSqlQuery *m_channelExistsQuery = nullptr;
+    QSqlQuery *m_channelsQuery = nullptr;
+    QSqlQuery *m_channelQuery = nullptr;
+
+    QSqlQuery *m_addChannelProviderQuery = nullptr;
+    QSqlQuery *m_channelProvidersQuery = nullptr;
+    QSqlQuery *m_nativeChannelProvidersQuery = nullptr;
+
+    QSqlQuery *m_addFavoriteQuery = nullptr;
+    QSqlQuery *m_removeFavoriteQuery = nullptr;
+    QSqlQuery *m_clearFavoritesQuery = nullptr;
+    QSqlQuery *m_favoriteCountQuery = nullptr;
+    QSqlQuery *m_favoritesQuery = nullptr;
+    QSqlQuery *m_isFavoriteQuery = nullptr;
+
+    QSqlQuery *m_addProgramQuery = nullptr;
+    QSqlQuery *m_updateProgramDescriptionQuery = nullptr;
+    QSqlQuery *m_programDescriptionQuery = nullptr;
+    QSqlQuery *m_programExistsQuery = nullptr;
+    QSqlQuery *m_programCountQuery = nullptr;
+    QSqlQuery *m_programsQuery = nullptr;
+    QSqlQuery *m_programsPerChannelQuery = nullptr;
+    QSqlQuery *m_programsPerChannelInRangeQuery = nullptr;
+    QSqlQuery *m_favoriteProgramsWithoutDescriptionQuery = nullptr;
+
+    bool m_open = false;
+    qint64 m_busyTime = 0; // [us]
 };
@@ -0,0 +1,157 @@
+#include "descriptionqueue.h"
+
+#include "database.h"
+
+#include <QDebug>
+#include <QUrl>
+
+#include <algorithm>
+
+namespace
+{
+// QNetworkAccessManager opens up to 6 connections per host, keep some for the program fetches
+const int MAX_REQUESTS_PER_HOST = 4;
+// store when that many descriptions are available (or after the timeout)
+const int STORE_BATCH_SIZE = 50;
+const int STORE_TIMEOUT = 500; // [ms]
+}
+
+DescriptionQueue::DescriptionQueue(const FetchFunction &fetch, QObject *parent)
+    : QObject(parent)
+    , m_fetch(fetch)
+{
+    m_storeTimer.setSingleShot(true);
+    m_storeTimer.setInterval(STORE_TIMEOUT);
+    connect(&m_storeTimer, &QTimer::timeout, this, &DescriptionQueue::store);
+}
+
+void DescriptionQueue::request(const ChannelId &channelId, const ProgramId &programId, const QString &url)
+{
+    if (m_inFlight.contains(programId)) {
+        m_inFlight[programId].m_requested = true; // prefetch running: store it as soon as it is there
+        return;
+    }
+    if (m_queued.contains(programId)) {
+        for (int i = 0; i < m_queue.size(); ++i) {
+            if (m_queue.at(i).m_programId == programId) {
+                m_queue.removeAt(i);
+                break;
+            }
+        }
+    } else {
+        m_queued.insert(programId);
+    }
+
+    Entry entry;
+    entry.m_channelId = channelId;
+    entry.m_programId = programId;
+    entry.m_url = url;
+    entry.m_host = QUrl(url).host();
+    entry.m_requested = true;
+    m_queue.prepend(entry);
+
+    start();
+}
+
+void DescriptionQueue::prefetch(const QVector<ProgramData> &programs)
+{
+    // the visible window changed: the old prefetch is obsolete (running requests are finished anyway)
+    const auto obsolete = std::remove_if(m_queue.begin(), m_queue.end(), [this](const Entry &entry) {
+        if (entry.m_requested) {
+            return false;
+        }
+        m_queued.remove(entry.m_programId);
+        return true;
+    });
+    m_queue.erase(obsolete, m_queue.end());
+
+    for (const ProgramData &program : programs) {
+        if (m_inFlight.contains(program.m_id) || m_descriptions.contains(program.m_id) || m_queued.contains(program.m_id)) {
+            continue;
+        }
+        m_queued.insert(program.m_id);
+        Entry entry;
+        entry.m_channelId = program.m_channelId;
+        entry.m_programId = program.m_id;
+        entry.m_url = program.m_url;
+        entry.m_host = QUrl(program.m_url).host();
+        entry.m_requested = false;
+        m_queue.append(entry);
+    }
+
+    start();
+}
+
+void DescriptionQueue::finished(const ChannelId &channelId, const ProgramId &programId, const QString &description)
+{
+    bool requested = false;
+    if (m_inFlight.contains(programId)) {
+        const Entry entry = m_inFlight.take(programId);
+        --m_inFlightPerHost[entry.m_host];
+        requested = entry.m_requested;
+    }
+
+    m_descriptions.insert(programId, description);
+    m_updatedChannels.insert(channelId);
+    // the user waits for a requested one
+    if (requested || m_descriptions.size() >= STORE_BATCH_SIZE) {
+        store();
+    } else if (!m_storeTimer.isActive()) {
+        m_storeTimer.start();
+    }
+
+    start();
+}
+
+void DescriptionQueue::failed(const ProgramId &programId)
+{
+    if (!m_inFlight.contains(programId)) {
+        return;
+    }
+    const Entry entry = m_inFlight.take(programId);
+    --m_inFlightPerHost[entry.m_host];
+
+    start();
+}
+
+bool DescriptionQueue::isIdle() const
+{
+    return m_queue.isEmpty() && m_inFlight.isEmpty() && m_descriptions.isEmpty();
+}
+
+void DescriptionQueue::start()
+{
+    for (auto it = m_queue.begin(); it != m_queue.end();) {
+        int &inFlight = m_inFlightPerHost[it->m_host];
+        if (inFlight >= MAX_REQUESTS_PER_HOST) {
+            ++it; // host is busy, maybe another one is not
+            continue;
+        }
+
+        const Entry entry = *it;
+        it = m_queue.erase(it);
+        m_queued.remove(entry.m_programId);
+        ++inFlight;
+        m_inFlight.insert(entry.m_programId, entry);
+
+        m_fetch(entry.m_channelId, entry.m_programId, entry.m_url);
+        // the fetch may have finished synchronously (and changed the queue)
+        it = m_queue.begin();
+    }
+}
+
+void DescriptionQueue::store()
+{
+    m_storeTimer.stop();
+    if (m_descriptions.isEmpty()) {
+        return;
+    }
+
+    qDebug() << "Store" << m_descriptions.size() << "program descriptions";
+    Database::instance().updateProgramDescriptions(m_descriptions);
+    m_descriptions.clear();
+
+    QSet<ChannelId> channelIds;
+    channelIds.swap(m_updatedChannels);
+    Q_EMIT descriptionsStored(channelIds);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QObject>
+
+#include "programdata.h"
+#include "types.h"
+
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QTimer>
+
+#include <functional>
+
+// fetches program descriptions in the background (e.g. for the visible part of the program table)
+// - most important programs first, explicit requests (user opens a program) before everything else
+// - every program only once at a time
+// - limited number of requests per host (leaves connections for the program fetches)
+// - prefetched descriptions are stored in batches (one transaction per batch), requested ones immediately
+class DescriptionQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    using FetchFunction = std::function<void(const ChannelId &channelId, const ProgramId &programId, const QString &url)>;
+
+    explicit DescriptionQueue(const FetchFunction &fetch, QObject *parent = nullptr);
+
+    void request(const ChannelId &channelId, const ProgramId &programId, const QString &url); // next
+    void prefetch(const QVector<ProgramData> &programs); // replaces the previous prefetch (sorted by priority)
+
+    // results of the fetch function
+    void finished(const ChannelId &channelId, const ProgramId &programId, const QString &description);
+    void failed(const ProgramId &programId);
+
+    bool isIdle() const; // nothing queued, running or waiting to be stored
+
+Q_SIGNALS:
+    void descriptionsStored(const QSet<ChannelId> &channelIds);
+
+private:
+    struct Entry {
+        ChannelId m_channelId;
+        ProgramId m_programId;
+        QString m_url;
+        QString m_host;
+        bool m_requested; // explicit request (survives a new prefetch)
+    };
+
+    void start();
+    void store();
+
+    FetchFunction m_fetch;
+    QList<Entry> m_queue;
+    QSet<ProgramId> m_queued; // IDs of m_queue
+    QHash<ProgramId, Entry> m_inFlight;
+    QHash<QString, int> m_inFlightPerHost;
+
+    QHash<ProgramId, QString> m_descriptions; // fetched, not stored yet
+    QSet<ChannelId> m_updatedChannels;
+    QTimer m_storeTimer;
+};
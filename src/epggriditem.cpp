@@ -0,0 +1,298 @@
+#include "epggriditem.h"
+
+#include "epggridmodel.h"
+#include "programsmodel.h"
+#include "tracer.h"
+
+#include <QFontMetricsF>
+#include <QHash>
+#include <QImage>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPair>
+#include <QQuickWindow>
+#include <QSGGeometryNode>
+#include <QSGSimpleTextureNode>
+#include <QSGVertexColorMaterial>
+#include <QStaticText>
+
+#include <algorithm>
+
+namespace
+{
+const qreal TEXT_PADDING = 3; // [px]
+const int MAX_TEXT_LINES = 8; // longer texts are cut (the texture would be mostly empty)
+
+// rectangles of all cells in one geometry, texts as (atlas) textures by content
+class GridNode : public QSGNode
+{
+public:
+    GridNode()
+        : m_rectsNode(new QSGGeometryNode)
+    {
+        QSGGeometry *geometry = new QSGGeometry(QSGGeometry::defaultAttributes_ColoredPoint2D(), 0);
+        geometry->setDrawingMode(QSGGeometry::DrawTriangles);
+        m_rectsNode->setGeometry(geometry);
+        m_rectsNode->setFlag(QSGNode::OwnsGeometry);
+        m_rectsNode->setMaterial(new QSGVertexColorMaterial);
+        m_rectsNode->setFlag(QSGNode::OwnsMaterial);
+        appendChildNode(m_rectsNode);
+    }
+
+    QSGGeometryNode *m_rectsNode;
+    QHash<QString, QSGSimpleTextureNode *> m_textNodes; // by textKey()
+};
+
+void appendRect(QSGGeometry::ColoredPoint2D *&vertex, const QRectF &rect, const QColor &color)
+{
+    // premultiplied
+    const uchar alpha = color.alpha();
+    const uchar red = color.red() * alpha / 255;
+    const uchar green = color.green() * alpha / 255;
+    const uchar blue = color.blue() * alpha / 255;
+    const float left = rect.left();
+    const float top = rect.top();
+    const float right = rect.right();
+    const float bottom = rect.bottom();
+
+    (vertex++)->set(left, top, red, green, blue, alpha);
+    (vertex++)->set(right, top, red, green, blue, alpha);
+    (vertex++)->set(left, bottom, red, green, blue, alpha);
+    (vertex++)->set(right, top, red, green, blue, alpha);
+    (vertex++)->set(right, bottom, red, green, blue, alpha);
+    (vertex++)->set(left, bottom, red, green, blue, alpha);
+}
+
+QString textKey(const QString &text, const QRectF &rect, const QColor &color)
+{
+    return QStringLiteral("%1|%2,%3,%4,%5|%6").arg(text).arg(rect.x()).arg(rect.y()).arg(rect.width()).arg(rect.height()).arg(color.rgba());
+}
+
+QImage renderText(const QString &text, bool richText, const QSizeF &size, const QFont &font, const QColor &color, qreal devicePixelRatio)
+{
+    QImage image((size * devicePixelRatio).toSize(), QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(devicePixelRatio);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    painter.setFont(font);
+    painter.setPen(color);
+    if (richText) {
+        // the glyph layout is done once per text
+        QStaticText staticText(text);
+        staticText.setTextFormat(Qt::RichText);
+        staticText.setTextWidth(size.width());
+        painter.drawStaticText(QPointF(0, 0), staticText);
+    } else {
+        painter.drawText(QRectF(QPointF(0, 0), size), Qt::AlignCenter | Qt::TextWordWrap, text);
+    }
+    return image;
+}
+}
+
+EpgGridItem::EpgGridItem(QQuickItem *parent)
+    : QQuickItem(parent)
+{
+    setFlag(ItemHasContents);
+    setAcceptedMouseButtons(Qt::LeftButton);
+    connect(this, &EpgGridItem::styleChanged, this, &QQuickItem::update);
+}
+
+EpgGridModel *EpgGridItem::model() const
+{
+    return m_model;
+}
+
+void EpgGridItem::setModel(EpgGridModel *model)
+{
+    if (m_model == model) {
+        return;
+    }
+    if (m_model) {
+        disconnect(m_model, nullptr, this, nullptr);
+    }
+    m_model = model;
+
+    if (m_model) {
+        connect(m_model, &QAbstractItemModel::modelReset, this, &EpgGridItem::updateCells);
+        connect(m_model, &QAbstractItemModel::rowsInserted, this, &EpgGridItem::updateCells);
+        connect(m_model, &QAbstractItemModel::rowsRemoved, this, &EpgGridItem::updateCells);
+        connect(m_model, &QAbstractItemModel::dataChanged, this, &EpgGridItem::updateCells);
+        connect(m_model, &QObject::destroyed, this, &EpgGridItem::updateCells);
+    }
+    updateCells();
+    Q_EMIT modelChanged();
+}
+
+qreal EpgGridItem::currentTimestamp() const
+{
+    return m_currentTimestamp;
+}
+
+void EpgGridItem::setCurrentTimestamp(qreal currentTimestamp)
+{
+    if (m_currentTimestamp != currentTimestamp) {
+        m_currentTimestamp = currentTimestamp;
+        update();
+        Q_EMIT currentTimestampChanged();
+    }
+}
+
+void EpgGridItem::updateCells()
+{
+    m_cells.clear();
+    m_pressedCell = -1;
+    const int count = m_model ? m_model->rowCount(QModelIndex()) : 0;
+    m_cells.reserve(count);
+    for (int row = 0; row < count; ++row) {
+        const QModelIndex index = m_model->index(row, 0);
+        Cell cell;
+        cell.m_rect = QRectF(m_model->data(index, EpgGridModel::CellXRole).toReal(),
+                             m_model->data(index, EpgGridModel::CellYRole).toReal(),
+                             m_model->data(index, EpgGridModel::CellWidthRole).toReal(),
+                             m_model->data(index, EpgGridModel::CellHeightRole).toReal());
+        cell.m_column = m_model->data(index, EpgGridModel::ColumnRole).toInt();
+        cell.m_available = m_model->data(index, EpgGridModel::AvailableRole).toBool();
+        if (cell.m_available) {
+            cell.m_start = m_model->data(index, ProgramsModel::StartRole).toLongLong();
+            cell.m_stop = m_model->data(index, ProgramsModel::StopRole).toLongLong();
+            cell.m_text = QStringLiteral("<b>") + m_model->data(index, ProgramsModel::StartTextRole).toString() + QStringLiteral("</b> ")
+                + m_model->data(index, ProgramsModel::TitleRole).toString().toHtmlEscaped();
+        } else {
+            cell.m_start = cell.m_stop = 0;
+        }
+        m_cells.append(cell);
+    }
+    update();
+}
+
+QSGNode *EpgGridItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data)
+{
+    Q_UNUSED(data)
+    TRACE_FUNCTION("render");
+
+    GridNode *node = static_cast<GridNode *>(oldNode);
+    if (!node) {
+        node = new GridNode;
+    }
+
+    const qreal pxPerMin = m_model ? m_model->pxPerMin() : 1;
+    const qreal devicePixelRatio = window() ? window()->effectiveDevicePixelRatio() : 1;
+    const qreal lineSpacing = QFontMetricsF(m_font).lineSpacing();
+
+    // rectangles
+    QVector<QPair<QRectF, QColor>> rects;
+    rects.reserve(m_cells.size() * 6);
+    for (const Cell &cell : qAsConst(m_cells)) {
+        const QRectF &rect = cell.m_rect;
+        if (!cell.m_available) {
+            rects.append(qMakePair(rect, m_unavailableColor));
+        } else if (cell.m_column % 2 != 0) {
+            rects.append(qMakePair(rect, m_alternateBackgroundColor));
+        }
+        // running program: up to now (the cell may be clipped at the top, but not at the bottom)
+        if (cell.m_available && cell.m_start <= m_currentTimestamp && cell.m_stop >= m_currentTimestamp) {
+            const qreal bottom = std::max(rect.top(), rect.bottom() - (cell.m_stop - m_currentTimestamp) / 60000 * pxPerMin);
+            rects.append(qMakePair(QRectF(rect.left(), rect.top(), rect.width(), bottom - rect.top()), m_highlightColor));
+        }
+        if (m_borderColor.alpha() > 0) {
+            rects.append(qMakePair(QRectF(rect.left(), rect.top(), rect.width(), 1), m_borderColor));
+            rects.append(qMakePair(QRectF(rect.left(), rect.bottom() - 1, rect.width(), 1), m_borderColor));
+            rects.append(qMakePair(QRectF(rect.left(), rect.top(), 1, rect.height()), m_borderColor));
+            rects.append(qMakePair(QRectF(rect.right() - 1, rect.top(), 1, rect.height()), m_borderColor));
+        }
+    }
+    QSGGeometry *geometry = node->m_rectsNode->geometry();
+    geometry->allocate(rects.size() * 6);
+    QSGGeometry::ColoredPoint2D *vertex = geometry->vertexDataAsColoredPoint2D();
+    for (const QPair<QRectF, QColor> &rect : qAsConst(rects)) {
+        appendRect(vertex, rect.first, rect.second);
+    }
+    node->m_rectsNode->markDirty(QSGNode::DirtyGeometry);
+
+    // texts: unchanged ones keep their texture
+    QHash<QString, QSGSimpleTextureNode *> textNodes;
+    for (const Cell &cell : qAsConst(m_cells)) {
+        QRectF textRect;
+        QColor color = m_textColor;
+        if (cell.m_available) {
+            // do not show for short programs to avoid that text overlaps into next program
+            if (cell.m_rect.height() < pxPerMin * 4) {
+                continue;
+            }
+            textRect = cell.m_rect.adjusted(TEXT_PADDING, TEXT_PADDING, -TEXT_PADDING, -TEXT_PADDING);
+            textRect.setHeight(std::min(textRect.height(), MAX_TEXT_LINES * lineSpacing));
+            if (cell.m_stop < m_currentTimestamp) {
+                color = m_disabledTextColor;
+            }
+        } else {
+            // centered
+            const qreal height = std::min(cell.m_rect.height(), 2 * lineSpacing);
+            textRect = QRectF(cell.m_rect.left() + TEXT_PADDING, cell.m_rect.center().y() - height / 2, cell.m_rect.width() - 2 * TEXT_PADDING, height);
+        }
+        if (textRect.isEmpty()) {
+            continue;
+        }
+
+        const QString &text = cell.m_available ? cell.m_text : m_unavailableText;
+        const QString key = textKey(text, textRect, color);
+        if (textNodes.contains(key)) {
+            continue;
+        }
+        QSGSimpleTextureNode *textNode = node->m_textNodes.take(key);
+        if (!textNode) {
+            textNode = new QSGSimpleTextureNode;
+            textNode->setOwnsTexture(true);
+            textNode->setTexture(window()->createTextureFromImage(renderText(text, cell.m_available, textRect.size(), m_font, color, devicePixelRatio)));
+            textNode->setRect(textRect);
+            node->appendChildNode(textNode);
+        }
+        textNodes.insert(key, textNode);
+    }
+    // not visible anymore
+    for (QSGSimpleTextureNode *textNode : qAsConst(node->m_textNodes)) {
+        node->removeChildNode(textNode);
+        delete textNode;
+    }
+    node->m_textNodes = textNodes;
+
+    return node;
+}
+
+int EpgGridItem::cellAt(const QPointF &pos) const
+{
+    // sorted by column (i.e. x) and y
+    const auto it = std::partition_point(m_cells.begin(), m_cells.end(), [&pos](const Cell &cell) {
+        return cell.m_rect.right() <= pos.x() || (cell.m_rect.left() <= pos.x() && cell.m_rect.bottom() <= pos.y());
+    });
+    if (it == m_cells.end() || !it->m_rect.contains(pos)) {
+        return -1;
+    }
+    return static_cast<int>(it - m_cells.begin());
+}
+
+void EpgGridItem::mousePressEvent(QMouseEvent *event)
+{
+    m_pressedCell = cellAt(event->localPos());
+    if (m_pressedCell < 0 || !m_cells.at(m_pressedCell).m_available) {
+        m_pressedCell = -1;
+        event->ignore();
+        return;
+    }
+    event->accept();
+}
+
+void EpgGridItem::mouseReleaseEvent(QMouseEvent *event)
+{
+    // not if dragged to another cell (the Flickable takes the grab if it is scrolled)
+    if (m_pressedCell >= 0 && cellAt(event->localPos()) == m_pressedCell) {
+        Q_EMIT clicked(m_pressedCell);
+    }
+    m_pressedCell = -1;
+}
+
+void EpgGridItem::mouseUngrabEvent()
+{
+    // e.g. the Flickable took over: no click
+    m_pressedCell = -1;
+}
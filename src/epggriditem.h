@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QQuickItem>
+
+#include <QColor>
+#include <QFont>
+#include <QPointer>
+#include <QRectF>
+#include <QString>
+#include <QVector>
+
+class EpgGridModel;
+
+// draws the cells of an EpgGridModel (positioned in the content, i.e. the item has the size of the whole grid)
+// backgrounds, borders and the highlight of the running programs are one vertex colored geometry, the texts are
+// rasterized once per cell and kept as textures while the cell is visible (scrolling only moves the item)
+// clicks are hit-tested against the cells (instead of one MouseArea per cell)
+class EpgGridItem : public QQuickItem
+{
+    Q_OBJECT
+
+    Q_PROPERTY(EpgGridModel *model READ model WRITE setModel NOTIFY modelChanged)
+    Q_PROPERTY(qreal currentTimestamp READ currentTimestamp WRITE setCurrentTimestamp NOTIFY currentTimestampChanged) // [ms] since epoch
+    Q_PROPERTY(QFont font MEMBER m_font NOTIFY styleChanged)
+    Q_PROPERTY(QColor textColor MEMBER m_textColor NOTIFY styleChanged)
+    Q_PROPERTY(QColor disabledTextColor MEMBER m_disabledTextColor NOTIFY styleChanged) // programs which are over
+    Q_PROPERTY(QColor alternateBackgroundColor MEMBER m_alternateBackgroundColor NOTIFY styleChanged) // every 2nd column
+    Q_PROPERTY(QColor unavailableColor MEMBER m_unavailableColor NOTIFY styleChanged)
+    Q_PROPERTY(QColor highlightColor MEMBER m_highlightColor NOTIFY styleChanged) // running programs
+    Q_PROPERTY(QColor borderColor MEMBER m_borderColor NOTIFY styleChanged) // not drawn if transparent
+    Q_PROPERTY(QString unavailableText MEMBER m_unavailableText NOTIFY styleChanged)
+
+public:
+    explicit EpgGridItem(QQuickItem *parent = nullptr);
+    ~EpgGridItem() override = default;
+
+    EpgGridModel *model() const;
+    void setModel(EpgGridModel *model);
+
+    qreal currentTimestamp() const;
+    void setCurrentTimestamp(qreal currentTimestamp);
+
+Q_SIGNALS:
+    void modelChanged();
+    void currentTimestampChanged();
+    void styleChanged(); // any of the colors, font or text
+    void clicked(int row); // row in the model
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void mouseUngrabEvent() override;
+
+private:
+    // copy of the model rows (the scene graph is updated on the render thread)
+    struct Cell {
+        QRectF m_rect;
+        int m_column;
+        bool m_available;
+        qint64 m_start; // [ms] since epoch
+        qint64 m_stop;
+        QString m_text; // rich text
+    };
+
+    void updateCells();
+    int cellAt(const QPointF &pos) const; // row, -1 if none
+
+    QPointer<EpgGridModel> m_model;
+    QVector<Cell> m_cells; // sorted by column and y
+    qreal m_currentTimestamp = 0;
+    QFont m_font;
+    QColor m_textColor;
+    QColor m_disabledTextColor;
+    QColor m_alternateBackgroundColor;
+    QColor m_unavailableColor;
+    QColor m_highlightColor;
+    QColor m_borderColor;
+    QString m_unavailableText;
+    int m_pressedCell = -1;
+};
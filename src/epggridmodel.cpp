@@ -0,0 +1,361 @@
+#include "epggridmodel.h"
+
+#include "channel.h"
+#include "channelsmodel.h"
+#include "tracer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+const qreal OVERSCAN_PX = 200; // cells this close to the viewport are created already (smooth scrolling)
+}
+
+EpgGridModel::EpgGridModel(QObject *parent)
+    : SortedListModel(parent)
+{
+    m_updateTimer.setSingleShot(true);
+    m_updateTimer.setInterval(0);
+    connect(&m_updateTimer, &QTimer::timeout, this, &EpgGridModel::updateVisible);
+}
+
+QVariant EpgGridModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_visible.size()) {
+        return QVariant();
+    }
+    const VisibleCell &cell = m_visible.at(index.row());
+
+    switch (role) {
+    case ColumnRole:
+        return cell.m_column;
+    case CellXRole:
+        return cell.m_rect.x();
+    case CellYRole:
+        return cell.m_rect.y();
+    case CellWidthRole:
+        return cell.m_rect.width();
+    case CellHeightRole:
+        return cell.m_rect.height();
+    case AvailableRole:
+        return cell.m_available;
+    case ProgramsModel::ChannelIdRole:
+        return cell.m_channelId;
+    default:
+        return cell.m_available ? ProgramsModel::programData(cell.m_program, role) : QVariant();
+    }
+}
+
+QHash<int, QByteArray> EpgGridModel::roleNames() const
+{
+    QHash<int, QByteArray> roleNames;
+    roleNames[ProgramsModel::IdRole] = "id";
+    roleNames[ProgramsModel::ChannelIdRole] = "channelId";
+    roleNames[ProgramsModel::UrlRole] = "url";
+    roleNames[ProgramsModel::StartRole] = "start";
+    roleNames[ProgramsModel::StopRole] = "stop";
+    roleNames[ProgramsModel::TitleRole] = "title";
+    roleNames[ProgramsModel::SubtitleRole] = "subtitle";
+    roleNames[ProgramsModel::DescriptionRole] = "description";
+    roleNames[ProgramsModel::DescriptionFetchedRole] = "descriptionFetched";
+    roleNames[ProgramsModel::CategoryRole] = "category";
+    roleNames[ProgramsModel::StartTextRole] = "startText";
+    roleNames[ProgramsModel::StopTextRole] = "stopText";
+    roleNames[ColumnRole] = "column";
+    roleNames[CellXRole] = "cellX";
+    roleNames[CellYRole] = "cellY";
+    roleNames[CellWidthRole] = "cellWidth";
+    roleNames[CellHeightRole] = "cellHeight";
+    roleNames[AvailableRole] = "available";
+    return roleNames;
+}
+
+int EpgGridModel::rowCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent)
+    return m_visible.size();
+}
+
+QVariantMap EpgGridModel::get(int row) const
+{
+    QVariantMap map;
+    if (row < 0 || row >= m_visible.size()) {
+        return map;
+    }
+    const QHash<int, QByteArray> names = roleNames();
+    for (auto it = names.constBegin(); it != names.constEnd(); ++it) {
+        map.insert(QString::fromUtf8(it.value()), data(index(row, 0), it.key()));
+    }
+    return map;
+}
+
+int EpgGridModel::find(const QString &programId) const
+{
+    for (int row = 0; row < m_visible.size(); ++row) {
+        if (m_visible.at(row).m_available && m_visible.at(row).m_program.m_id.value() == programId) {
+            return row;
+        }
+    }
+    return -1;
+}
+
+ChannelsModel *EpgGridModel::channelsModel() const
+{
+    return m_channelsModel;
+}
+
+void EpgGridModel::setChannelsModel(ChannelsModel *channelsModel)
+{
+    if (m_channelsModel == channelsModel) {
+        return;
+    }
+    if (m_channelsModel) {
+        disconnect(m_channelsModel, nullptr, this, nullptr);
+    }
+    m_channelsModel = channelsModel;
+
+    if (m_channelsModel) {
+        // channel data (e.g. name) is not shown in the grid
+        connect(m_channelsModel, &QAbstractItemModel::modelReset, this, &EpgGridModel::rebuildColumns);
+        connect(m_channelsModel, &QAbstractItemModel::rowsInserted, this, &EpgGridModel::rebuildColumns);
+        connect(m_channelsModel, &QAbstractItemModel::rowsRemoved, this, &EpgGridModel::rebuildColumns);
+        connect(m_channelsModel, &QAbstractItemModel::rowsMoved, this, &EpgGridModel::rebuildColumns);
+        connect(m_channelsModel, &QObject::destroyed, this, &EpgGridModel::rebuildColumns);
+    }
+    rebuildColumns();
+    Q_EMIT channelsModelChanged();
+}
+
+QDateTime EpgGridModel::start() const
+{
+    return m_start;
+}
+
+void EpgGridModel::setStart(const QDateTime &start)
+{
+    if (m_start != start) {
+        m_start = start;
+        invalidateLayout();
+        Q_EMIT startChanged();
+    }
+}
+
+QDateTime EpgGridModel::stop() const
+{
+    return m_stop;
+}
+
+void EpgGridModel::setStop(const QDateTime &stop)
+{
+    if (m_stop != stop) {
+        m_stop = stop;
+        invalidateLayout();
+        Q_EMIT stopChanged();
+    }
+}
+
+qreal EpgGridModel::pxPerMin() const
+{
+    return m_pxPerMin;
+}
+
+void EpgGridModel::setPxPerMin(qreal pxPerMin)
+{
+    if (m_pxPerMin != pxPerMin) {
+        m_pxPerMin = pxPerMin;
+        invalidateLayout();
+        Q_EMIT pxPerMinChanged();
+    }
+}
+
+qreal EpgGridModel::columnWidth() const
+{
+    return m_columnWidth;
+}
+
+void EpgGridModel::setColumnWidth(qreal columnWidth)
+{
+    if (m_columnWidth != columnWidth) {
+        m_columnWidth = columnWidth;
+        invalidateLayout();
+        Q_EMIT columnWidthChanged();
+    }
+}
+
+QRectF EpgGridModel::viewport() const
+{
+    return m_viewport;
+}
+
+void EpgGridModel::setViewport(const QRectF &viewport)
+{
+    if (m_viewport != viewport) {
+        m_viewport = viewport;
+        // immediately: the cells must be there when the frame is rendered
+        updateVisible();
+        Q_EMIT viewportChanged();
+    }
+}
+
+qreal EpgGridModel::contentWidth() const
+{
+    return m_columns.size() * m_columnWidth;
+}
+
+qreal EpgGridModel::contentHeight() const
+{
+    if (!m_start.isValid() || !m_stop.isValid()) {
+        return 0;
+    }
+    return std::max<qint64>(0, m_stop.toSecsSinceEpoch() - m_start.toSecsSinceEpoch()) / 60.0 * m_pxPerMin;
+}
+
+void EpgGridModel::rebuildColumns()
+{
+    for (const Column &column : qAsConst(m_columns)) {
+        if (column.m_programsModel) {
+            disconnect(column.m_programsModel, nullptr, this, nullptr);
+        }
+    }
+    m_columns.clear();
+
+    const int count = m_channelsModel ? m_channelsModel->rowCount(QModelIndex()) : 0;
+    m_columns.resize(count);
+    for (int i = 0; i < count; ++i) {
+        Channel *channel = m_channelsModel->data(m_channelsModel->index(i, 0), ChannelsModel::ChannelRole).value<Channel *>();
+        if (!channel) {
+            continue;
+        }
+        Column &column = m_columns[i];
+        column.m_programsModel = channel->programsModel();
+        column.m_channelId = channel->id();
+
+        ProgramsModel *programsModel = column.m_programsModel;
+        const auto invalidate = [this, programsModel]() {
+            invalidateColumn(programsModel);
+        };
+        connect(programsModel, &QAbstractItemModel::modelReset, this, invalidate);
+        connect(programsModel, &QAbstractItemModel::rowsInserted, this, invalidate);
+        connect(programsModel, &QAbstractItemModel::rowsRemoved, this, invalidate);
+        connect(programsModel, &QAbstractItemModel::dataChanged, this, invalidate);
+    }
+
+    Q_EMIT contentSizeChanged();
+    m_updateTimer.start();
+}
+
+void EpgGridModel::invalidateColumn(const ProgramsModel *programsModel)
+{
+    for (Column &column : m_columns) {
+        if (column.m_programsModel == programsModel) {
+            column.m_dirty = true;
+        }
+    }
+    m_updateTimer.start();
+}
+
+void EpgGridModel::invalidateLayout()
+{
+    for (Column &column : m_columns) {
+        column.m_dirty = true;
+    }
+    Q_EMIT contentSizeChanged();
+    m_updateTimer.start();
+}
+
+void EpgGridModel::layoutColumn(int columnIndex)
+{
+    Column &column = m_columns[columnIndex];
+    column.m_cells.clear();
+    column.m_dirty = false;
+
+    const qreal x = columnIndex * m_columnWidth;
+    if (!m_start.isValid() || !m_stop.isValid()) {
+        return;
+    }
+    const qint64 start = m_start.toSecsSinceEpoch();
+    const qint64 stop = m_stop.toSecsSinceEpoch();
+
+    if (column.m_programsModel) {
+        const QVector<ProgramRowData> &programs = column.m_programsModel->programs();
+        for (auto it = ProgramsModel::firstNotEnded(programs, start); it != programs.end() && it->m_start < stop; ++it) {
+            // clipped to [start, stop]
+            const qint64 programStart = std::max(it->m_start, start);
+            const qint64 programStop = std::min(it->m_stop, stop);
+            const QRectF rect(x, (programStart - start) / 60.0 * m_pxPerMin, m_columnWidth, (programStop - programStart) / 60.0 * m_pxPerMin);
+            column.m_cells.append(Cell{rect, static_cast<int>(it - programs.begin())});
+        }
+    }
+
+    if (column.m_cells.isEmpty()) {
+        column.m_cells.append(Cell{QRectF(x, 0, m_columnWidth, contentHeight()), -1});
+    }
+}
+
+QVector<EpgGridModel::VisibleCell> EpgGridModel::findVisible()
+{
+    QVector<VisibleCell> cells;
+    if (m_columns.isEmpty() || m_columnWidth <= 0 || m_viewport.isEmpty()) {
+        return cells;
+    }
+    const QRectF area = m_viewport.adjusted(-OVERSCAN_PX, -OVERSCAN_PX, OVERSCAN_PX, OVERSCAN_PX);
+
+    // columns have a fixed width: no search required
+    const int firstColumn = std::max(0, static_cast<int>(std::floor(area.left() / m_columnWidth)));
+    const int lastColumn = std::min(m_columns.size() - 1, static_cast<int>(std::ceil(area.right() / m_columnWidth)) - 1);
+
+    for (int i = firstColumn; i <= lastColumn; ++i) {
+        if (m_columns.at(i).m_dirty) {
+            layoutColumn(i);
+        }
+        const Column &column = m_columns.at(i);
+
+        // cells sorted by y: binary search for the first one in the area
+        const auto first = std::partition_point(column.m_cells.begin(), column.m_cells.end(), [&area](const Cell &cell) {
+            return cell.m_rect.bottom() <= area.top();
+        });
+        for (auto it = first; it != column.m_cells.end() && it->m_rect.top() < area.bottom(); ++it) {
+            VisibleCell cell;
+            cell.m_column = i;
+            cell.m_rect = it->m_rect;
+            cell.m_available = it->m_row >= 0;
+            cell.m_channelId = column.m_channelId;
+            if (cell.m_available) {
+                cell.m_program = column.m_programsModel->programs().at(it->m_row);
+                cell.m_key = cell.m_program.m_start;
+            } else {
+                cell.m_key = std::numeric_limits<qint64>::min();
+            }
+            cells.append(cell);
+        }
+    }
+    return cells;
+}
+
+void EpgGridModel::updateVisible()
+{
+    TRACE_FUNCTION("model");
+    m_updateTimer.stop();
+
+    mergeRows(
+        m_visible,
+        findVisible(),
+        &EpgGridModel::isBefore,
+        [](const VisibleCell &l, const VisibleCell &r) {
+            return !isBefore(l, r) && !isBefore(r, l);
+        },
+        &EpgGridModel::isSame);
+}
+
+bool EpgGridModel::isBefore(const VisibleCell &l, const VisibleCell &r)
+{
+    return l.m_column < r.m_column || (l.m_column == r.m_column && l.m_key < r.m_key);
+}
+
+bool EpgGridModel::isSame(const VisibleCell &l, const VisibleCell &r)
+{
+    return l.m_rect == r.m_rect && l.m_available == r.m_available && l.m_channelId == r.m_channelId
+        && (!l.m_available || ProgramsModel::isSame(l.m_program, r.m_program));
+}
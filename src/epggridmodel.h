@@ -0,0 +1,127 @@
+#pragma once
+
+#include "programrowdata.h"
+#include "programsmodel.h"
+#include "sortedlistmodel.h"
+
+#include <QDateTime>
+#include <QPointer>
+#include <QRectF>
+#include <QTimer>
+#include <QVariantMap>
+#include <QVector>
+
+class ChannelsModel;
+
+// programs of all channels as one grid: a column per channel, the time [start, stop] from top to bottom
+// the pixel rectangle of every program is computed once (on changes only), the rows of the model are the cells
+// in the viewport only, i.e. QML creates delegates for the visible programs and positions them absolutely
+class EpgGridModel : public SortedListModel
+{
+    Q_OBJECT
+
+    Q_PROPERTY(ChannelsModel *channelsModel READ channelsModel WRITE setChannelsModel NOTIFY channelsModelChanged)
+    Q_PROPERTY(QDateTime start READ start WRITE setStart NOTIFY startChanged)
+    Q_PROPERTY(QDateTime stop READ stop WRITE setStop NOTIFY stopChanged)
+    Q_PROPERTY(qreal pxPerMin READ pxPerMin WRITE setPxPerMin NOTIFY pxPerMinChanged)
+    Q_PROPERTY(qreal columnWidth READ columnWidth WRITE setColumnWidth NOTIFY columnWidthChanged)
+    Q_PROPERTY(QRectF viewport READ viewport WRITE setViewport NOTIFY viewportChanged) // visible part of the content
+    Q_PROPERTY(qreal contentWidth READ contentWidth NOTIFY contentSizeChanged)
+    Q_PROPERTY(qreal contentHeight READ contentHeight NOTIFY contentSizeChanged)
+
+public:
+    // the ProgramsModel roles and the cell
+    enum Role {
+        ColumnRole = ProgramsModel::StopTextRole + 1, // int, row in the ChannelsModel
+        CellXRole, // [px] in the content
+        CellYRole,
+        CellWidthRole,
+        CellHeightRole,
+        AvailableRole, // bool, false: no programs for the channel in [start, stop], the cell is the whole column
+    };
+    Q_ENUM(Role)
+
+    explicit EpgGridModel(QObject *parent = nullptr);
+    ~EpgGridModel() override = default;
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+    int rowCount(const QModelIndex &parent) const override;
+
+    Q_INVOKABLE QVariantMap get(int row) const; // role name -> value
+    Q_INVOKABLE int find(const QString &programId) const; // row, -1 if not visible
+
+    ChannelsModel *channelsModel() const;
+    void setChannelsModel(ChannelsModel *channelsModel);
+
+    QDateTime start() const;
+    void setStart(const QDateTime &start);
+
+    QDateTime stop() const;
+    void setStop(const QDateTime &stop);
+
+    qreal pxPerMin() const;
+    void setPxPerMin(qreal pxPerMin);
+
+    qreal columnWidth() const;
+    void setColumnWidth(qreal columnWidth);
+
+    QRectF viewport() const;
+    void setViewport(const QRectF &viewport);
+
+    qreal contentWidth() const;
+    qreal contentHeight() const;
+
+Q_SIGNALS:
+    void channelsModelChanged();
+    void startChanged();
+    void stopChanged();
+    void pxPerMinChanged();
+    void columnWidthChanged();
+    void viewportChanged();
+    void contentSizeChanged();
+
+private:
+    struct Cell {
+        QRectF m_rect;
+        int m_row; // in the ProgramsModel, -1 if not available
+    };
+
+    struct Column {
+        QPointer<ProgramsModel> m_programsModel;
+        QString m_channelId;
+        QVector<Cell> m_cells; // sorted by y (programs do not overlap)
+        bool m_dirty = true; // cells must be computed again
+    };
+
+    // copy of the data: stays valid while the ProgramsModel changes
+    struct VisibleCell {
+        int m_column;
+        qint64 m_key; // [s] start of the program, unique within the column
+        QRectF m_rect;
+        bool m_available;
+        QString m_channelId;
+        ProgramRowData m_program;
+    };
+
+    void rebuildColumns();
+    void invalidateColumn(const ProgramsModel *programsModel);
+    void invalidateLayout();
+    void layoutColumn(int columnIndex);
+    QVector<VisibleCell> findVisible(); // lays out dirty columns first
+    void updateVisible(); // applies the changes only
+
+    static bool isBefore(const VisibleCell &l, const VisibleCell &r);
+    static bool isSame(const VisibleCell &l, const VisibleCell &r);
+
+    QPointer<ChannelsModel> m_channelsModel;
+    QDateTime m_start;
+    QDateTime m_stop;
+    qreal m_pxPerMin = 1.0;
+    qreal m_columnWidth = 200.0;
+    QRectF m_viewport;
+
+    QVector<Column> m_columns; // one per row of the ChannelsModel
+    QVector<VisibleCell> m_visible; // sorted by column and key
+    QTimer m_updateTimer; // coalesces the changes of the programs and the layout
+};
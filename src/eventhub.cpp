@@ -0,0 +1,59 @@
+#include "eventhub.h"
+
+#include "fetcher.h"
+
+EventHub::EventHub()
+    : QObject(nullptr)
+{
+    // one connection per signal, dispatched by ID
+    Fetcher &fetcher = Fetcher::instance();
+    connect(&fetcher, &Fetcher::startedFetchingChannel, this, [this](const ChannelId &id) {
+        m_channelFetchStarted.dispatch(id);
+    });
+    connect(&fetcher, &Fetcher::channelUpdated, this, [this](const ChannelId &id) {
+        m_channelUpdated.dispatch(id);
+    });
+    connect(&fetcher, &Fetcher::errorFetchingChannel, this, [this](const ChannelId &id, const Error &error) {
+        m_channelFetchFailed.dispatch(id, error);
+    });
+
+    connect(&fetcher, &Fetcher::startedFetchingCountry, this, [this](const CountryId &id) {
+        m_countryFetchStarted.dispatch(id);
+    });
+    connect(&fetcher, &Fetcher::countryUpdated, this, [this](const CountryId &id) {
+        m_countryUpdated.dispatch(id);
+    });
+    connect(&fetcher, &Fetcher::errorFetchingCountry, this, [this](const CountryId &id, const Error &error) {
+        m_countryFetchFailed.dispatch(id, error);
+    });
+}
+
+EventDispatcher<ChannelId> &EventHub::channelFetchStarted()
+{
+    return m_channelFetchStarted;
+}
+
+EventDispatcher<ChannelId> &EventHub::channelUpdated()
+{
+    return m_channelUpdated;
+}
+
+EventDispatcher<ChannelId, const Error &> &EventHub::channelFetchFailed()
+{
+    return m_channelFetchFailed;
+}
+
+EventDispatcher<CountryId> &EventHub::countryFetchStarted()
+{
+    return m_countryFetchStarted;
+}
+
+EventDispatcher<CountryId> &EventHub::countryUpdated()
+{
+    return m_countryUpdated;
+}
+
+EventDispatcher<CountryId, const Error &> &EventHub::countryFetchFailed()
+{
+    return m_countryFetchFailed;
+}
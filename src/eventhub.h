@@ -0,0 +1,115 @@
+#pragma once
+
+#include <QObject>
+
+#include "types.h"
+
+#include <QHash>
+#include <QMultiHash>
+#include <QPointer>
+#include <QVector>
+
+#include <functional>
+
+// calls the handlers subscribed to a single ID (hash lookup instead of every subscriber comparing IDs)
+// handlers are removed when their context is destroyed
+template<class Id, class... Args>
+class EventDispatcher
+{
+public:
+    using Handler = std::function<void(Args...)>;
+
+    EventDispatcher() = default;
+    ~EventDispatcher()
+    {
+        // the contexts may outlive the dispatcher
+        for (const QMetaObject::Connection &connection : qAsConst(m_connections)) {
+            QObject::disconnect(connection);
+        }
+    }
+
+    void subscribe(const Id &id, QObject *context, const Handler &handler)
+    {
+        if (!m_ids.contains(context)) {
+            m_connections.insert(context, QObject::connect(context, &QObject::destroyed, [this, context]() {
+                unsubscribe(context);
+            }));
+        }
+        m_ids[context].append(id);
+        m_subscriptions.insert(id, Subscription{context, context, handler});
+    }
+
+    void unsubscribe(QObject *context)
+    {
+        QObject::disconnect(m_connections.take(context));
+        const QVector<Id> ids = m_ids.take(context);
+        for (const Id &id : ids) {
+            auto it = m_subscriptions.find(id);
+            while (it != m_subscriptions.end() && it.key() == id) {
+                if (it->m_context == context) {
+                    it = m_subscriptions.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+
+    void dispatch(const Id &id, Args... args) const
+    {
+        // copy: handlers may (un)subscribe
+        const QList<Subscription> subscriptions = m_subscriptions.values(id);
+        for (const Subscription &subscription : subscriptions) {
+            // a previous handler may have deleted it
+            if (subscription.m_guard) {
+                subscription.m_handler(args...);
+            }
+        }
+    }
+
+private:
+    Q_DISABLE_COPY(EventDispatcher)
+
+    struct Subscription {
+        QObject *m_context;
+        QPointer<QObject> m_guard; // already null while the context is destroyed
+        Handler m_handler;
+    };
+
+    QMultiHash<Id, Subscription> m_subscriptions;
+    QHash<QObject *, QVector<Id>> m_ids; // context -> subscribed IDs
+    QHash<QObject *, QMetaObject::Connection> m_connections; // context -> destroyed()
+};
+
+// Fetcher events per channel/country
+// GUI thread only
+class EventHub : public QObject
+{
+    Q_OBJECT
+
+public:
+    static EventHub &instance()
+    {
+        static EventHub _instance;
+        return _instance;
+    }
+
+    EventDispatcher<ChannelId> &channelFetchStarted();
+    EventDispatcher<ChannelId> &channelUpdated();
+    EventDispatcher<ChannelId, const Error &> &channelFetchFailed();
+
+    EventDispatcher<CountryId> &countryFetchStarted();
+    EventDispatcher<CountryId> &countryUpdated();
+    EventDispatcher<CountryId, const Error &> &countryFetchFailed();
+
+private:
+    EventHub();
+
+    EventDispatcher<ChannelId> m_channelFetchStarted;
+    EventDispatcher<ChannelId> m_channelUpdated;
+    EventDispatcher<ChannelId, const Error &> m_channelFetchFailed;
+
+    EventDispatcher<CountryId> m_countryFetchStarted;
+    EventDispatcher<CountryId> m_countryUpdated;
+    EventDispatcher<CountryId, const Error &> m_countryFetchFailed;
+};
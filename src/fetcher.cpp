@@ -1,140 +1,493 @@
 #include "fetcher.h"
 
 #include "database.h"
+#include "descriptionqueue.h"
+#include "parserpool.h"
+#include "startup.h"
 #include "tvspielfilmfetcher.h"
+#include "xmltvfilefetcher.h"
 #include "xmltvsefetcher.h"
 
 #include <KLocalizedString>
 
-#include <QCryptographicHash>
 #include <QDebug>
-#include <QFile>
-#include <QFileInfo>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
-#include <QNetworkRequest>
-#include <QStandardPaths>
+#include <QTimer>
+#include <QUrl>
 
-#define USE_TVSPIELFILM
+#include <algorithm>
+
+namespace
+{
+// weight of a new measurement in the moving averages
+const double SMOOTHING = 0.3;
+// assumed latency of providers without measurement [ms]
+const double UNKNOWN_LATENCY = 1000;
+// an error rate of 100% counts like a 4 times higher latency
+const double ERROR_WEIGHT = 3;
+// providers with that many errors in a row are considered down (only used if nothing else is left)
+const int MAX_CONSECUTIVE_ERRORS = 3;
+const double DOWN_PENALTY = 1e6;
+}
 
 Fetcher::Fetcher()
-    :
-#ifdef USE_TVSPIELFILM
-    m_fetcherImpl(new TvSpielfilmFetcher)
-#else
-    m_fetcherImpl(new XmlTvSeFetcher)
-#endif
-{
-    m_manager = new QNetworkAccessManager(this);
-    m_manager->setRedirectPolicy(QNetworkRequest::NoLessSafeRedirectPolicy);
-    m_manager->setStrictTransportSecurityEnabled(true);
-    m_manager->enableStrictTransportSecurityStore(true);
-
-    connect(m_fetcherImpl.get(), &FetcherImpl::startedFetchingCountry, this, [this](const CountryId &id) {
-        Q_EMIT startedFetchingCountry(id);
-    });
-    connect(m_fetcherImpl.get(), &FetcherImpl::countryUpdated, this, [this](const CountryId &id) {
-        Q_EMIT countryUpdated(id);
+{
+    m_descriptionQueue = new DescriptionQueue(
+        [this](const ChannelId &channelId, const ProgramId &programId, const QString &url) {
+            // the description URL belongs to the provider which fetched the program
+            FetcherImpl *fetcherImpl = fetcherForUrl(url);
+            if (fetcherImpl) {
+                fetcherImpl->fetchProgramDescription(channelId, programId, url);
+            } else {
+                m_descriptionQueue->failed(programId);
+            }
+        },
+        this);
+    connect(m_descriptionQueue, &DescriptionQueue::descriptionsStored, this, [this](const QSet<ChannelId> &channelIds) {
+        for (const ChannelId &channelId : channelIds) {
+            Q_EMIT channelUpdated(channelId);
+        }
     });
 
-    connect(m_fetcherImpl.get(), &FetcherImpl::startedFetchingChannel, this, [this](const ChannelId &id) {
-        Q_EMIT startedFetchingChannel(id);
+    registerFetcher(new TvSpielfilmFetcher);
+    registerFetcher(new XmlTvSeFetcher);
+
+    m_fileFetcher = new XmlTvFileFetcher;
+    registerFetcher(m_fileFetcher);
+    connect(m_fileFetcher, &XmlTvFileFetcher::importProgress, this, &Fetcher::importProgress);
+    connect(m_fileFetcher, &XmlTvFileFetcher::importFinished, this, &Fetcher::importFinished);
+
+    connect(&Database::instance(), &Database::channelAdded, this, &Fetcher::onChannelAdded);
+}
+
+bool Fetcher::isIdle() const
+{
+    for (const FetcherImpl *fetcherImpl : m_fetchers) {
+        if (fetcherImpl->isBusy()) {
+            return false;
+        }
+    }
+    return !m_prefetchScheduled && m_descriptionQueue->isIdle() && ParserPool::instance().pendingCount() == 0;
+}
+
+void Fetcher::registerFetcher(FetcherImpl *fetcherImpl)
+{
+    if (fetcher(fetcherImpl->name())) {
+        qWarning() << "Provider" << fetcherImpl->name() << "is already registered";
+        delete fetcherImpl;
+        return;
+    }
+    qDebug() << "Registered provider" << fetcherImpl->name();
+
+    fetcherImpl->setParent(this);
+    m_fetchers.append(fetcherImpl);
+
+    connect(fetcherImpl, &FetcherImpl::startedFetchingCountry, this, &Fetcher::startedFetchingCountry);
+    connect(fetcherImpl, &FetcherImpl::countryUpdated, this, &Fetcher::countryUpdated);
+
+    connect(fetcherImpl, &FetcherImpl::startedFetchingChannel, this, [this, fetcherImpl](const ChannelId &id) {
+        onStartedFetchingChannel(fetcherImpl, id);
     });
-    connect(m_fetcherImpl.get(), &FetcherImpl::channelUpdated, this, [this](const ChannelId &id) {
-        Q_EMIT channelUpdated(id);
+    connect(fetcherImpl, &FetcherImpl::channelUpdated, this, [this, fetcherImpl](const ChannelId &id) {
+        onChannelUpdated(fetcherImpl, id);
     });
-    connect(m_fetcherImpl.get(), &FetcherImpl::channelDetailsUpdated, this, [this](const ChannelId &id, const QString &image) {
-        Q_EMIT channelDetailsUpdated(id, image);
+    connect(fetcherImpl, &FetcherImpl::programFetchFinished, this, [this, fetcherImpl](const ChannelId &id) {
+        onProgramFetchFinished(fetcherImpl, id);
     });
+    connect(fetcherImpl, &FetcherImpl::channelDetailsUpdated, this, &Fetcher::channelDetailsUpdated);
+    connect(fetcherImpl, &FetcherImpl::programDescriptionUpdated, m_descriptionQueue, &DescriptionQueue::finished);
 
-    connect(m_fetcherImpl.get(), &FetcherImpl::errorFetching, this, [this](const Error &error) {
-        Q_EMIT errorFetching(error);
-    });
-    connect(m_fetcherImpl.get(), &FetcherImpl::errorFetchingCountry, this, [this](const CountryId &id, const Error &error) {
-        Q_EMIT errorFetchingCountry(id, error);
+    connect(fetcherImpl, &FetcherImpl::errorFetching, this, &Fetcher::errorFetching);
+    connect(fetcherImpl, &FetcherImpl::errorFetchingCountry, this, &Fetcher::errorFetchingCountry);
+    connect(fetcherImpl, &FetcherImpl::errorFetchingChannel, this, [this, fetcherImpl](const ChannelId &id, const Error &error) {
+        onErrorFetchingChannel(fetcherImpl, id, error);
     });
-    connect(m_fetcherImpl.get(), &FetcherImpl::errorFetchingChannel, this, [this](const ChannelId &id, const Error &error) {
-        Q_EMIT errorFetchingChannel(id, error);
-    });
-    connect(m_fetcherImpl.get(), &FetcherImpl::errorFetchingProgram, this, [this](const ProgramId &id, const Error &error) {
+    connect(fetcherImpl, &FetcherImpl::errorFetchingProgram, this, [this](const ProgramId &id, const Error &error) {
+        m_descriptionQueue->failed(id);
         Q_EMIT errorFetchingProgram(id, error);
     });
 }
 
+FetcherImpl *Fetcher::fetcher(const QString &name) const
+{
+    for (FetcherImpl *fetcherImpl : m_fetchers) {
+        if (fetcherImpl->name() == name) {
+            return fetcherImpl;
+        }
+    }
+    return nullptr;
+}
+
+FetcherImpl *Fetcher::fetcherForUrl(const QString &url) const
+{
+    const QUrl qurl(url);
+    for (FetcherImpl *fetcherImpl : m_fetchers) {
+        if (fetcherImpl->handlesUrl(qurl)) {
+            return fetcherImpl;
+        }
+    }
+    return nullptr;
+}
+
 void Fetcher::fetchFavorites()
 {
-    qDebug() << "Starting to fetch favorites";
+    const QDate today = QDate::currentDate();
+    fetchFavorites({today.addDays(-1), today, today.addDays(1)});
+}
+
+void Fetcher::fetchFavoritesDay(const QDateTime &day)
+{
+    fetchFavorites({day.date()});
+}
+
+void Fetcher::fetchFavorites(const QVector<QDate> &days)
+{
+    // called by QML while starting up: wait until the database is open
+    if (!Startup::instance().isDatabaseReady()) {
+        Startup::instance().whenDatabaseReady(this, [this, days]() {
+            fetchFavorites(days);
+        });
+        return;
+    }
+    qDebug() << "Starting to fetch favorites" << days;
 
     const QVector<ChannelId> favoriteChannels = Database::instance().favorites();
     for (int i = 0; i < favoriteChannels.length(); i++) {
-        m_fetcherImpl->fetchProgram(favoriteChannels.at(i));
+        const ChannelId &channelId = favoriteChannels.at(i);
+        auto it = m_channelFetches.find(channelId);
+        if (it != m_channelFetches.end()) {
+            // still fetching (removed when finished): the current provider fetches the additional days, the tried providers stay excluded
+            QVector<QDate> newDays;
+            for (const QDate &day : days) {
+                if (!it->m_days.contains(day)) {
+                    newDays.append(day);
+                }
+            }
+            if (!newDays.isEmpty()) {
+                it->m_days += newDays;
+                ++it->m_running;
+                // measure the latency of the new days (the previous ones may have been reported long ago)
+                it->m_measured = false;
+                it->m_timer.start();
+                // the provider may report the result synchronously, do not touch it afterwards
+                fetcher(it->m_provider)->fetchProgram(channelId, it->m_providerChannelId, newDays);
+            }
+            continue;
+        }
+
+        m_channelFetches[channelId].m_days = days;
+        if (!fetchProgram(channelId)) {
+            qWarning() << "No provider for channel" << channelId.value();
+        }
     }
 }
 
-void Fetcher::fetchCountries()
+bool Fetcher::fetchProgram(const ChannelId &channelId)
 {
-    m_fetcherImpl->fetchCountries();
+    ChannelFetch &channelFetch = m_channelFetches[channelId];
+
+    QVector<ChannelProviderData> candidates;
+    for (const ChannelProviderData &provider : channelProviders(channelId)) {
+        if (!channelFetch.m_triedProviders.contains(provider.m_provider)) {
+            candidates.append(provider);
+        }
+    }
+    if (candidates.isEmpty()) {
+        m_channelFetches.remove(channelId);
+        return false;
+    }
+
+    // stable: keep the registration order for providers which are equally good
+    std::stable_sort(candidates.begin(), candidates.end(), [this](const ChannelProviderData &l, const ChannelProviderData &r) {
+        return score(l.m_provider) < score(r.m_provider);
+    });
+    const ChannelProviderData best = candidates.first();
+
+    channelFetch.m_triedProviders.insert(best.m_provider);
+    channelFetch.m_provider = best.m_provider;
+    channelFetch.m_providerChannelId = best.m_providerChannelId;
+    channelFetch.m_measured = false;
+    channelFetch.m_timer.start();
+    channelFetch.m_running = 1;
+
+    if (best.m_providerChannelId != channelId) {
+        qDebug() << "Fetching program for" << channelId.value() << "from" << best.m_provider << "(" << best.m_providerChannelId.value() << ")";
+    }
+    // the provider may report the result synchronously, do not touch channelFetch afterwards
+    const QVector<QDate> days = channelFetch.m_days;
+    fetcher(best.m_provider)->fetchProgram(channelId, best.m_providerChannelId, days);
+    return true;
 }
 
-void Fetcher::fetchCountry(const QString &url, const QString &countryId)
+QVector<ChannelProviderData> Fetcher::channelProviders(const ChannelId &channelId)
 {
-    fetchCountry(url, CountryId(countryId));
+    QVector<ChannelProviderData> providers;
+    bool hasNative = false;
+    for (const ChannelProviderData &provider : Database::instance().channelProviders(channelId)) {
+        if (fetcher(provider.m_provider)) {
+            providers.append(provider);
+        }
+        hasNative = hasNative || provider.m_providerChannelId == channelId;
+    }
+
+    // channels added before the mapping was stored: the URL tells which provider added it
+    if (!hasNative) {
+        FetcherImpl *fetcherImpl = fetcherForUrl(Database::instance().channel(channelId).m_url);
+        if (fetcherImpl) {
+            Database::instance().addChannelProvider(channelId, fetcherImpl->name(), channelId);
+            ChannelProviderData provider;
+            provider.m_channelId = channelId;
+            provider.m_provider = fetcherImpl->name();
+            provider.m_providerChannelId = channelId;
+            providers.prepend(provider);
+        }
+    }
+    return providers;
 }
 
-void Fetcher::fetchCountry(const QString &url, const CountryId &countryId)
+double Fetcher::score(const QString &provider) const
 {
-    m_fetcherImpl->fetchCountry(url, countryId);
+    const ProviderStats stats = m_providerStats.value(provider);
+    double score = (stats.m_latency < 0 ? UNKNOWN_LATENCY : stats.m_latency) * (1 + ERROR_WEIGHT * stats.m_errorRate);
+    if (stats.m_consecutiveErrors >= MAX_CONSECUTIVE_ERRORS) {
+        score += DOWN_PENALTY;
+    }
+    return score;
 }
 
-void Fetcher::fetchProgramDescription(const QString &channelId, const QString &programId, const QString &url)
+void Fetcher::onChannelUpdated(FetcherImpl *fetcherImpl, const ChannelId &channelId)
 {
-    m_fetcherImpl->fetchProgramDescription(ChannelId(channelId), ProgramId(programId), url);
+    auto it = m_channelFetches.find(channelId);
+    if (it != m_channelFetches.end() && it->m_provider == fetcherImpl->name()) {
+        recordResult(fetcherImpl->name(), *it, true);
+
+        // new programs (without description) may be in the prefetch window
+        if (m_prefetchTo.isValid() && !m_prefetchScheduled) {
+            m_prefetchScheduled = true;
+            QTimer::singleShot(0, this, &Fetcher::updatePrefetch);
+        }
+    }
+    Q_EMIT channelUpdated(channelId);
 }
 
-QString Fetcher::image(const QString &url)
+void Fetcher::onErrorFetchingChannel(FetcherImpl *fetcherImpl, const ChannelId &channelId, const Error &error)
 {
-    QString path = filePath(url);
-    if (QFileInfo::exists(path)) {
-        return path;
+    auto it = m_channelFetches.find(channelId);
+    if (it == m_channelFetches.end()) {
+        Q_EMIT errorFetchingChannel(channelId, error);
+        return;
+    }
+    if (it->m_provider != fetcherImpl->name()) {
+        return; // provider was replaced already
     }
+    recordResult(fetcherImpl->name(), *it, false);
 
-    download(url);
+    qWarning() << "Provider" << fetcherImpl->name() << "failed for channel" << channelId.value() << ", trying next provider";
+    if (!fetchProgram(channelId)) {
+        Q_EMIT errorFetchingChannel(channelId, error);
+    }
+}
+
+void Fetcher::onProgramFetchFinished(FetcherImpl *fetcherImpl, const ChannelId &channelId)
+{
+    auto it = m_channelFetches.find(channelId);
+    if (it == m_channelFetches.end() || it->m_provider != fetcherImpl->name()) {
+        return; // provider was replaced already
+    }
 
-    return QLatin1String("");
+    // all requested days are done: the next fetch selects the provider again
+    if (--it->m_running == 0) {
+        m_channelFetches.erase(it);
+    }
 }
 
-void Fetcher::download(const QString &url)
+void Fetcher::recordResult(const QString &provider, ChannelFetch &channelFetch, bool success)
 {
-    QNetworkRequest request((QUrl(url)));
-    QNetworkReply *reply = get(request);
-    connect(reply, &QNetworkReply::finished, this, [this, url, reply]() {
-        if (reply->error() == QNetworkReply::NoError) {
-            QByteArray data = reply->readAll();
-            QFile file(filePath(url));
-            file.open(QIODevice::WriteOnly);
-            file.write(data);
-            file.close();
+    ProviderStats &stats = m_providerStats[provider];
+    ++stats.m_requests;
+    stats.m_errorRate = (1 - SMOOTHING) * stats.m_errorRate + SMOOTHING * (success ? 0 : 1);
+    stats.m_consecutiveErrors = success ? 0 : stats.m_consecutiveErrors + 1;
+
+    // latency until the first result (later results of the same fetch are just other days/pages)
+    if (success && !channelFetch.m_measured) {
+        channelFetch.m_measured = true;
+        const double latency = channelFetch.m_timer.elapsed();
+        stats.m_latency = stats.m_latency < 0 ? latency : (1 - SMOOTHING) * stats.m_latency + SMOOTHING * latency;
+    }
+}
+
+void Fetcher::onStartedFetchingChannel(FetcherImpl *fetcherImpl, const ChannelId &channelId)
+{
+    m_addingChannels.insert(channelId, fetcherImpl->name());
+    Q_EMIT startedFetchingChannel(channelId);
+}
+
+void Fetcher::onChannelAdded(const ChannelId &channelId)
+{
+    const QString provider = m_addingChannels.take(channelId);
+    if (provider.isEmpty()) {
+        return;
+    }
+    Database::instance().addChannelProvider(channelId, provider, channelId);
+
+    // same channel from other providers (matched by name)
+    loadChannelIndex();
+    const QString name = normalizedName(Database::instance().channel(channelId).m_name);
+    if (name.isEmpty()) {
+        return;
+    }
+    QVector<ChannelProviderData> &channels = m_channelIndex[name];
+    for (const ChannelProviderData &other : qAsConst(channels)) {
+        if (other.m_provider != provider) {
+            Database::instance().addChannelProvider(channelId, other.m_provider, other.m_channelId);
+            Database::instance().addChannelProvider(other.m_channelId, provider, channelId);
         }
-        Q_EMIT imageDownloadFinished(url);
+    }
 
-        delete reply;
-    });
+    ChannelProviderData data;
+    data.m_channelId = channelId;
+    data.m_provider = provider;
+    data.m_providerChannelId = channelId;
+    channels.append(data);
+}
+
+void Fetcher::loadChannelIndex()
+{
+    if (m_channelIndexLoaded) {
+        return;
+    }
+    m_channelIndexLoaded = true;
+
+    const QMap<ChannelId, QString> nativeProviders = Database::instance().nativeChannelProviders();
+    for (const ChannelData &channel : Database::instance().channels(false)) {
+        QString provider = nativeProviders.value(channel.m_id);
+        if (provider.isEmpty()) {
+            const FetcherImpl *fetcherImpl = fetcherForUrl(channel.m_url);
+            if (!fetcherImpl) {
+                continue;
+            }
+            provider = fetcherImpl->name();
+        }
+
+        ChannelProviderData data;
+        data.m_channelId = channel.m_id;
+        data.m_provider = provider;
+        data.m_providerChannelId = channel.m_id;
+        m_channelIndex[normalizedName(channel.m_name)].append(data);
+    }
 }
 
-void Fetcher::removeImage(const QString &url)
+QString Fetcher::normalizedName(const QString &name)
 {
-    qDebug() << "Remove image: " << filePath(url);
-    QFile(filePath(url)).remove();
+    // e.g. "Das Erste" and "das-erste" (ignore case, spaces and punctuation)
+    QString normalized;
+    normalized.reserve(name.size());
+    for (const QChar c : name) {
+        if (c.isLetterOrNumber()) {
+            normalized.append(c.toLower());
+        }
+    }
+    return normalized;
 }
 
-QString Fetcher::filePath(const QString &url)
+void Fetcher::fetchCountries()
 {
-    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + QStringLiteral("/")
-        + QString::fromStdString(QCryptographicHash::hash(url.toUtf8(), QCryptographicHash::Md5).toHex().toStdString());
+    if (!Startup::instance().isDatabaseReady()) {
+        Startup::instance().whenDatabaseReady(this, [this]() {
+            fetchCountries();
+        });
+        return;
+    }
+    // the catalogue contains the countries of all providers
+    for (FetcherImpl *fetcherImpl : qAsConst(m_fetchers)) {
+        fetcherImpl->fetchCountries();
+    }
 }
 
-QNetworkReply *Fetcher::get(QNetworkRequest &request)
+void Fetcher::fetchCountry(const QString &url, const QString &countryId)
 {
-    request.setRawHeader("User-Agent", "telly-skout/0.1");
-    return m_manager->get(request);
+    if (!Startup::instance().isDatabaseReady()) {
+        Startup::instance().whenDatabaseReady(this, [this, url, countryId]() {
+            fetchCountry(url, countryId);
+        });
+        return;
+    }
+    fetchCountry(url, CountryId(countryId));
+}
+
+void Fetcher::fetchCountry(const QString &url, const CountryId &countryId)
+{
+    FetcherImpl *fetcherImpl = fetcherForUrl(url);
+    if (!fetcherImpl) {
+        qWarning() << "No provider for country" << countryId.value() << "(" << url << ")";
+        return;
+    }
+    fetcherImpl->fetchCountry(url, countryId);
+}
+
+void Fetcher::fetchProgramDescription(const QString &channelId, const QString &programId, const QString &url)
+{
+    if (!Startup::instance().isDatabaseReady()) {
+        Startup::instance().whenDatabaseReady(this, [this, channelId, programId, url]() {
+            fetchProgramDescription(channelId, programId, url);
+        });
+        return;
+    }
+    // before all prefetched descriptions
+    m_descriptionQueue->request(ChannelId(channelId), ProgramId(programId), url);
+}
+
+void Fetcher::prefetchDescriptions(const QDateTime &from, const QDateTime &to)
+{
+    if (!Startup::instance().isDatabaseReady()) {
+        Startup::instance().whenDatabaseReady(this, [this, from, to]() {
+            prefetchDescriptions(from, to);
+        });
+        return;
+    }
+    m_prefetchFrom = from;
+    m_prefetchTo = to;
+    updatePrefetch();
+}
+
+void Fetcher::updatePrefetch()
+{
+    m_prefetchScheduled = false;
+
+    const QVector<ProgramData> programs = Database::instance().favoriteProgramsWithoutDescription(m_prefetchFrom.toSecsSinceEpoch(), m_prefetchTo.toSecsSinceEpoch());
+
+    // running + next programs of all channels first, then the later ones, past programs last (most recent first)
+    const QDateTime now = QDateTime::currentDateTime();
+    QHash<ChannelId, int> ranks;
+    QVector<QPair<int, int>> upcoming; // rank in channel, index in programs
+    QVector<ProgramData> prioritized;
+    prioritized.reserve(programs.size());
+    for (int i = 0; i < programs.size(); ++i) {
+        if (programs.at(i).m_stopTime > now) {
+            upcoming.append(qMakePair(ranks[programs.at(i).m_channelId]++, i));
+        }
+    }
+    std::stable_sort(upcoming.begin(), upcoming.end(), [](const QPair<int, int> &l, const QPair<int, int> &r) {
+        return l.first < r.first;
+    });
+    for (const QPair<int, int> &entry : qAsConst(upcoming)) {
+        prioritized.append(programs.at(entry.second));
+    }
+    for (int i = programs.size() - 1; i >= 0; --i) {
+        if (programs.at(i).m_stopTime <= now) {
+            prioritized.append(programs.at(i));
+        }
+    }
+
+    m_descriptionQueue->prefetch(prioritized);
+}
+
+void Fetcher::importFile(const QString &path)
+{
+    if (!Startup::instance().isDatabaseReady()) {
+        Startup::instance().whenDatabaseReady(this, [this, path]() {
+            importFile(path);
+        });
+        return;
+    }
+    m_fileFetcher->importFile(path);
 }
@@ -1,16 +1,19 @@
 #pragma once
 
+#include "channelproviderdata.h"
 #include "fetcherimpl.h"
 #include "types.h"
 
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QObject>
+#include <QSet>
+#include <QVector>
 
-#include <memory>
-
-class QNetworkAccessManager;
-class QNetworkReply;
-class QNetworkRequest;
+class DescriptionQueue;
 class QString;
+class XmlTvFileFetcher;
 
 class Fetcher : public QObject
 {
@@ -21,23 +24,72 @@ public:
         static Fetcher _instance;
         return _instance;
     }
-    Q_INVOKABLE void fetchFavorites();
+    Q_INVOKABLE void fetchFavorites(); // yesterday, today and tomorrow
+    Q_INVOKABLE void fetchFavoritesDay(const QDateTime &day); // local day of day (e.g. before it is scrolled into view)
     Q_INVOKABLE void fetchCountries();
     Q_INVOKABLE void fetchCountry(const QString &url, const QString &countryId);
     void fetchCountry(const QString &url, const CountryId &countryId);
     Q_INVOKABLE void fetchProgramDescription(const QString &channelId, const QString &programId, const QString &url);
-    Q_INVOKABLE QString image(const QString &url);
-    Q_INVOKABLE void download(const QString &url);
+    // fetches the missing descriptions of the favorites in the background (e.g. visible time window)
+    Q_INVOKABLE void prefetchDescriptions(const QDateTime &from, const QDateTime &to);
+    Q_INVOKABLE void importFile(const QString &path); // local XMLTV file (plain or .gz)
+
+    // nothing is fetched, parsed or stored anymore (e.g. to quit after a batch refresh)
+    bool isIdle() const;
+
+    // takes ownership, providers registered first are preferred as long as nothing is known about their performance
+    void registerFetcher(FetcherImpl *fetcherImpl);
 
 private:
     Fetcher();
 
-    QString filePath(const QString &url);
-    void removeImage(const QString &url);
-    QNetworkReply *get(QNetworkRequest &request);
+    FetcherImpl *fetcher(const QString &name) const;
+    FetcherImpl *fetcherForUrl(const QString &url) const;
+
+    // provider selection + failover
+    struct ProviderStats {
+        int m_requests = 0;
+        int m_consecutiveErrors = 0;
+        double m_latency = -1; // [ms], moving average, < 0 if unknown
+        double m_errorRate = 0; // moving average
+    };
+    struct ChannelFetch {
+        QSet<QString> m_triedProviders;
+        QString m_provider; // currently fetching
+        ChannelId m_providerChannelId;
+        QElapsedTimer m_timer;
+        bool m_measured = false;
+        QVector<QDate> m_days; // all requested days (for the next provider if this one fails)
+        int m_running = 0; // fetchProgram() calls of m_provider which are not finished yet
+    };
+    void fetchFavorites(const QVector<QDate> &days);
+    bool fetchProgram(const ChannelId &channelId); // false if there is no (untried) provider left
+    QVector<ChannelProviderData> channelProviders(const ChannelId &channelId);
+    double score(const QString &provider) const; // lower is better
+    void onChannelUpdated(FetcherImpl *fetcherImpl, const ChannelId &channelId);
+    void onErrorFetchingChannel(FetcherImpl *fetcherImpl, const ChannelId &channelId, const Error &error);
+    void onProgramFetchFinished(FetcherImpl *fetcherImpl, const ChannelId &channelId);
+    void recordResult(const QString &provider, ChannelFetch &channelFetch, bool success);
+
+    // channel ID mapping between providers
+    void onStartedFetchingChannel(FetcherImpl *fetcherImpl, const ChannelId &channelId);
+    void onChannelAdded(const ChannelId &channelId);
+    void loadChannelIndex();
+    static QString normalizedName(const QString &name);
+
+    void updatePrefetch();
 
-    QNetworkAccessManager *m_manager;
-    std::unique_ptr<FetcherImpl> m_fetcherImpl;
+    QVector<FetcherImpl *> m_fetchers;
+    XmlTvFileFetcher *m_fileFetcher;
+    DescriptionQueue *m_descriptionQueue;
+    QDateTime m_prefetchFrom;
+    QDateTime m_prefetchTo;
+    bool m_prefetchScheduled = false;
+    QHash<QString, ProviderStats> m_providerStats;
+    QHash<ChannelId, ChannelFetch> m_channelFetches;
+    QHash<ChannelId, QString> m_addingChannels; // channel -> provider which is adding it
+    QHash<QString, QVector<ChannelProviderData>> m_channelIndex; // normalized channel name -> channels of all providers
+    bool m_channelIndexLoaded = false;
 
 Q_SIGNALS:
     void startedFetchingCountry(const CountryId &id);
@@ -52,5 +104,6 @@ Q_SIGNALS:
     void errorFetchingChannel(const ChannelId &id, const Error &error);
     void errorFetchingProgram(const ProgramId &id, const Error &error);
 
-    void imageDownloadFinished(const QString &url);
+    void importProgress(const QString &path, qint64 bytesRead, qint64 bytesTotal);
+    void importFinished(const QString &path, qint64 programCount);
 };
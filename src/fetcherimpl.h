@@ -4,7 +4,11 @@
 
 #include "types.h"
 
+#include <QVector>
+
+class QDate;
 class QString;
+class QUrl;
 
 class FetcherImpl : public QObject
 {
@@ -12,9 +16,16 @@ class FetcherImpl : public QObject
 public:
     virtual ~FetcherImpl() = default;
 
+    virtual QString name() const = 0; // unique, persisted
+    virtual bool handlesUrl(const QUrl &url) const = 0; // country/channel/program URLs created by this provider
+    virtual bool isBusy() const = 0; // requests running (results may still arrive)
+
     virtual void fetchCountries() = 0;
     virtual void fetchCountry(const QString &url, const CountryId &countryId) = 0;
-    virtual void fetchProgram(const ChannelId &channelId) = 0;
+    // programs are stored for channelId, providerChannelId is the ID of the channel for this provider
+    // days (local) are a hint for providers which fetch per day, missing ones are fetched only
+    // programFetchFinished() is emitted when all days are done (also if nothing had to be fetched or a day failed)
+    virtual void fetchProgram(const ChannelId &channelId, const ChannelId &providerChannelId, const QVector<QDate> &days) = 0;
     virtual void fetchProgramDescription(const ChannelId &channelId, const ProgramId &programId, const QString &url) = 0;
 
 Q_SIGNALS:
@@ -23,7 +34,9 @@ Q_SIGNALS:
 
     void startedFetchingChannel(const ChannelId &id);
     void channelUpdated(const ChannelId &id);
+    void programFetchFinished(const ChannelId &id); // after channelUpdated()/errorFetchingChannel()
     void channelDetailsUpdated(const ChannelId &id, const QString &image);
+    void programDescriptionUpdated(const ChannelId &channelId, const ProgramId &programId, const QString &description); // not stored yet
 
     void errorFetching(const Error &error);
     void errorFetchingCountry(const CountryId &id, const Error &error);
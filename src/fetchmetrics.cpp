@@ -0,0 +1,229 @@
+#include "fetchmetrics.h"
+
+#include "parserpool.h"
+
+#include <QDebug>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkReply>
+#include <QSaveFile>
+
+namespace
+{
+const int MAX_FINISHED_REQUESTS = 1000;
+const int UPDATE_INTERVAL = 500; // [ms]
+
+double milliseconds(qint64 microseconds)
+{
+    return microseconds / 1000.0;
+}
+}
+
+FetchMetrics::FetchMetrics()
+    : QObject(nullptr)
+{
+    m_updateTimer.setSingleShot(true);
+    m_updateTimer.setInterval(UPDATE_INTERVAL);
+    connect(&m_updateTimer, &QTimer::timeout, this, &FetchMetrics::updated);
+
+    connect(&ParserPool::instance(), &ParserPool::jobFinished, this, [this](const QString &, qint64 waitTime, qint64 parseTime, QObject *context) {
+        onJobFinished(waitTime, parseTime, context);
+    });
+}
+
+void FetchMetrics::requestStarted(QNetworkReply *reply, const QString &provider, const ChannelId &channelId)
+{
+    Request &request = m_running[reply];
+    request.m_provider = provider;
+    request.m_channelId = channelId;
+    request.m_url = reply->url().toString();
+    request.m_timer.start();
+
+    connect(reply, &QNetworkReply::metaDataChanged, this, [this, reply]() {
+        auto it = m_running.find(reply);
+        if (it != m_running.end() && it->m_timeToFirstByte < 0) {
+            it->m_timeToFirstByte = it->m_timer.nsecsElapsed() / 1000;
+        }
+    });
+    connect(reply, &QNetworkReply::downloadProgress, this, [this, reply](qint64 bytesReceived) {
+        auto it = m_running.find(reply);
+        if (it != m_running.end()) {
+            it->m_bytes = bytesReceived;
+        }
+    });
+    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+        auto it = m_running.find(reply);
+        if (it != m_running.end()) {
+            it->m_networkTime = it->m_timer.nsecsElapsed() / 1000;
+            it->m_status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+            if (reply->error() != QNetworkReply::NoError) {
+                it->m_error = reply->errorString();
+            }
+        }
+    });
+    // parsing and storing happen before the reply is deleted
+    connect(reply, &QObject::destroyed, this, [this, reply]() {
+        finish(reply);
+    });
+}
+
+void FetchMetrics::recordStored(QObject *reply, int rows, qint64 databaseTime)
+{
+    auto it = m_running.find(reply);
+    if (it != m_running.end()) {
+        it->m_rows += rows;
+        it->m_databaseTime += databaseTime;
+    }
+}
+
+void FetchMetrics::onJobFinished(qint64 waitTime, qint64 parseTime, QObject *context)
+{
+    auto it = m_running.find(context);
+    if (it != m_running.end()) {
+        it->m_parseWaitTime += waitTime;
+        it->m_parseTime += parseTime;
+        ++it->m_parseJobs;
+    }
+}
+
+void FetchMetrics::finish(QObject *reply)
+{
+    auto it = m_running.find(reply);
+    if (it == m_running.end()) {
+        return;
+    }
+    const Request request = *it;
+    m_running.erase(it);
+
+    add(m_totals, request);
+    add(m_providers[request.m_provider], request);
+    if (!request.m_channelId.value().isEmpty()) {
+        add(m_channels[request.m_channelId], request);
+    }
+
+    m_finished.enqueue(request);
+    if (m_finished.size() > MAX_FINISHED_REQUESTS) {
+        m_finished.dequeue();
+    }
+
+    if (!m_updateTimer.isActive()) {
+        m_updateTimer.start();
+    }
+}
+
+void FetchMetrics::add(Totals &totals, const Request &request)
+{
+    ++totals.m_requests;
+    if (!request.m_error.isEmpty()) {
+        ++totals.m_errors;
+    }
+    totals.m_bytes += request.m_bytes;
+    totals.m_networkTime += request.m_networkTime;
+    totals.m_parseWaitTime += request.m_parseWaitTime;
+    totals.m_parseTime += request.m_parseTime;
+    totals.m_rows += request.m_rows;
+    totals.m_databaseTime += request.m_databaseTime;
+}
+
+QVariantMap FetchMetrics::totals() const
+{
+    return toVariant(m_totals);
+}
+
+QVariantList FetchMetrics::providers() const
+{
+    QVariantList providers;
+    for (auto it = m_providers.constBegin(); it != m_providers.constEnd(); ++it) {
+        QVariantMap provider = toVariant(it.value());
+        provider.insert(QStringLiteral("provider"), it.key());
+        providers.append(provider);
+    }
+    return providers;
+}
+
+QVariantList FetchMetrics::channels() const
+{
+    QVariantList channels;
+    for (auto it = m_channels.constBegin(); it != m_channels.constEnd(); ++it) {
+        QVariantMap channel = toVariant(it.value());
+        channel.insert(QStringLiteral("channel"), it.key().value());
+        channels.append(channel);
+    }
+    return channels;
+}
+
+QVariantList FetchMetrics::requests() const
+{
+    QVariantList requests;
+    requests.reserve(m_finished.size());
+    for (auto it = m_finished.crbegin(); it != m_finished.crend(); ++it) {
+        requests.append(toVariant(*it));
+    }
+    return requests;
+}
+
+QString FetchMetrics::toJson() const
+{
+    QVariantMap metrics;
+    metrics.insert(QStringLiteral("totals"), totals());
+    metrics.insert(QStringLiteral("providers"), providers());
+    metrics.insert(QStringLiteral("channels"), channels());
+    metrics.insert(QStringLiteral("requests"), requests());
+    return QString::fromUtf8(QJsonDocument(QJsonObject::fromVariantMap(metrics)).toJson());
+}
+
+bool FetchMetrics::saveJson(const QString &path) const
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(toJson().toUtf8()) < 0 || !file.commit()) {
+        qWarning() << "Failed to save fetch metrics to" << path << ":" << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+void FetchMetrics::reset()
+{
+    // running requests are still counted when they are finished
+    m_finished.clear();
+    m_totals = Totals();
+    m_providers.clear();
+    m_channels.clear();
+    Q_EMIT updated();
+}
+
+QVariantMap FetchMetrics::toVariant(const Totals &totals)
+{
+    QVariantMap map;
+    map.insert(QStringLiteral("requests"), totals.m_requests);
+    map.insert(QStringLiteral("errors"), totals.m_errors);
+    map.insert(QStringLiteral("bytes"), totals.m_bytes);
+    map.insert(QStringLiteral("networkTime"), milliseconds(totals.m_networkTime));
+    map.insert(QStringLiteral("parseWaitTime"), milliseconds(totals.m_parseWaitTime));
+    map.insert(QStringLiteral("parseTime"), milliseconds(totals.m_parseTime));
+    map.insert(QStringLiteral("rows"), totals.m_rows);
+    map.insert(QStringLiteral("databaseTime"), milliseconds(totals.m_databaseTime));
+    return map;
+}
+
+QVariantMap FetchMetrics::toVariant(const Request &request)
+{
+    // times in ms
+    QVariantMap map;
+    map.insert(QStringLiteral("provider"), request.m_provider);
+    map.insert(QStringLiteral("channel"), request.m_channelId.value());
+    map.insert(QStringLiteral("url"), request.m_url);
+    map.insert(QStringLiteral("status"), request.m_status);
+    map.insert(QStringLiteral("error"), request.m_error);
+    map.insert(QStringLiteral("timeToFirstByte"), request.m_timeToFirstByte < 0 ? QVariant() : QVariant(milliseconds(request.m_timeToFirstByte)));
+    map.insert(QStringLiteral("transferTime"),
+               request.m_timeToFirstByte < 0 ? QVariant() : QVariant(milliseconds(request.m_networkTime - request.m_timeToFirstByte)));
+    map.insert(QStringLiteral("networkTime"), milliseconds(request.m_networkTime));
+    map.insert(QStringLiteral("bytes"), request.m_bytes);
+    map.insert(QStringLiteral("parseWaitTime"), milliseconds(request.m_parseWaitTime));
+    map.insert(QStringLiteral("parseTime"), milliseconds(request.m_parseTime));
+    map.insert(QStringLiteral("parseJobs"), request.m_parseJobs);
+    map.insert(QStringLiteral("rows"), request.m_rows);
+    map.insert(QStringLiteral("databaseTime"), milliseconds(request.m_databaseTime));
+    return map;
+}
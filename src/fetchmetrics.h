@@ -0,0 +1,93 @@
+#pragma once
+
+#include <QObject>
+
+#include "types.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QQueue>
+#include <QString>
+#include <QTimer>
+#include <QVariantList>
+#include <QVariantMap>
+
+class QNetworkReply;
+
+// metrics of the fetch pipeline per request (network, parsing, database), aggregated per provider and channel
+// Qt 5 does not report DNS/connect/TLS timings: the time to the first byte includes them (and the wait for a free connection)
+// GUI thread only
+class FetchMetrics : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QVariantMap totals READ totals NOTIFY updated)
+    Q_PROPERTY(QVariantList providers READ providers NOTIFY updated)
+    Q_PROPERTY(QVariantList channels READ channels NOTIFY updated)
+    Q_PROPERTY(QVariantList requests READ requests NOTIFY updated) // most recent first
+
+public:
+    static FetchMetrics &instance()
+    {
+        static FetchMetrics _instance;
+        return _instance;
+    }
+
+    // called by the fetchers
+    void requestStarted(QNetworkReply *reply, const QString &provider, const ChannelId &channelId);
+    void recordStored(QObject *reply, int rows, qint64 databaseTime); // [us], rows stored because of the reply
+
+    QVariantMap totals() const;
+    QVariantList providers() const;
+    QVariantList channels() const;
+    QVariantList requests() const;
+
+    Q_INVOKABLE QString toJson() const;
+    Q_INVOKABLE bool saveJson(const QString &path) const;
+    Q_INVOKABLE void reset();
+
+Q_SIGNALS:
+    void updated(); // throttled
+
+private:
+    FetchMetrics();
+
+    struct Request {
+        QString m_provider;
+        ChannelId m_channelId;
+        QString m_url;
+        QElapsedTimer m_timer;
+        qint64 m_timeToFirstByte = -1; // [us], < 0 if there was no response
+        qint64 m_networkTime = 0; // [us], until the reply is finished
+        qint64 m_bytes = 0;
+        int m_status = 0; // HTTP
+        QString m_error;
+        qint64 m_parseWaitTime = 0; // [us], in the ParserPool queue
+        qint64 m_parseTime = 0; // [us]
+        int m_parseJobs = 0;
+        int m_rows = 0;
+        qint64 m_databaseTime = 0; // [us]
+    };
+    struct Totals {
+        int m_requests = 0;
+        int m_errors = 0;
+        qint64 m_bytes = 0;
+        qint64 m_networkTime = 0; // [us]
+        qint64 m_parseWaitTime = 0; // [us]
+        qint64 m_parseTime = 0; // [us]
+        qint64 m_rows = 0;
+        qint64 m_databaseTime = 0; // [us]
+    };
+
+    void onJobFinished(qint64 waitTime, qint64 parseTime, QObject *context);
+    void finish(QObject *reply); // destroyed: nothing happens for this request anymore
+    static void add(Totals &totals, const Request &request);
+    static QVariantMap toVariant(const Totals &totals);
+    static QVariantMap toVariant(const Request &request);
+
+    QHash<QObject *, Request> m_running;
+    QQueue<Request> m_finished; // most recent requests
+    Totals m_totals;
+    QHash<QString, Totals> m_providers;
+    QHash<ChannelId, Totals> m_channels;
+    QTimer m_updateTimer;
+};
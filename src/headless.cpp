@@ -0,0 +1,217 @@
+#include "headless.h"
+
+#include "channeldata.h"
+#include "database.h"
+#include "fetcher.h"
+#include "fetchmetrics.h"
+#include "programdata.h"
+#include "startup.h"
+#include "xmltvshards.h"
+
+#include <KLocalizedString>
+
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDebug>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QTimer>
+#include <QXmlStreamWriter>
+
+namespace
+{
+const int IDLE_CHECK_INTERVAL = 50; // [ms]
+const char *const HEADLESS_OPTIONS[] = {"refresh-favorites", "import", "query", "export", "benchmark-xmltv", "metrics"};
+const QString XMLTV_TIME_FORMAT = QStringLiteral("yyyyMMddHHmmss");
+}
+
+Headless::Headless()
+    : QObject(nullptr)
+    , m_refreshFavoritesOption(QStringLiteral("refresh-favorites"), i18n("Fetch the programs of all favorites and exit."))
+    , m_importOption(QStringLiteral("import"), i18n("Import the XMLTV file (plain or .gz) and exit."), QStringLiteral("file"))
+    , m_queryOption(QStringLiteral("query"),
+                    i18n("Print the programs of the channel between <from> and <to> (ISO 8601, default: the next 24 hours) and exit."),
+                    QStringLiteral("channel"))
+    , m_exportOption(QStringLiteral("export"), i18n("Write the favorites and their programs as XMLTV to stdout and exit."))
+    , m_benchmarkXmlTvOption(QStringLiteral("benchmark-xmltv"),
+                             i18n("Measure parsing the XMLTV file with 1 to N threads and exit."),
+                             QStringLiteral("file"))
+    , m_metricsOption(QStringLiteral("metrics"), i18n("Write the metrics of all requests as JSON to the file."), QStringLiteral("file"))
+{
+}
+
+void Headless::addOptions(QCommandLineParser &parser) const
+{
+    parser.addOption(m_refreshFavoritesOption);
+    parser.addOption(m_importOption);
+    parser.addOption(m_queryOption);
+    parser.addOption(m_exportOption);
+    parser.addOption(m_benchmarkXmlTvOption);
+    parser.addOption(m_metricsOption);
+    parser.addPositionalArgument(QStringLiteral("from"), i18n("Start of the --query range."), QStringLiteral("[from]"));
+    parser.addPositionalArgument(QStringLiteral("to"), i18n("End of the --query range."), QStringLiteral("[to]"));
+}
+
+bool Headless::isRequested(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        const QString argument = QString::fromLocal8Bit(argv[i]);
+        if (argument == QStringLiteral("--")) {
+            break;
+        }
+        for (const char *option : HEADLESS_OPTIONS) {
+            const QString name = QStringLiteral("--") + QLatin1String(option);
+            if (argument == name || argument.startsWith(name + QLatin1Char('='))) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+int Headless::exec(const QCommandLineParser &parser)
+{
+    if (parser.isSet(m_benchmarkXmlTvOption)) {
+        XmlTvShards::benchmark(parser.value(m_benchmarkXmlTvOption));
+        return 0;
+    }
+
+    Startup::instance().openDatabase();
+
+    Fetcher &fetcher = Fetcher::instance();
+    connect(&fetcher, &Fetcher::errorFetching, this, [this](const Error &error) {
+        qWarning().noquote() << i18n("Error:") << error.m_message;
+        ++m_errors;
+    });
+    connect(&fetcher, &Fetcher::errorFetchingChannel, this, [this](const ChannelId &id, const Error &error) {
+        qWarning().noquote() << i18n("Error fetching %1:", id.value()) << error.m_message;
+        ++m_errors;
+    });
+
+    // fetches first (query and export show the result)
+    if (parser.isSet(m_importOption)) {
+        const QString path = QFileInfo(parser.value(m_importOption)).absoluteFilePath();
+        connect(&fetcher, &Fetcher::importFinished, this, [path](const QString &importedPath, qint64 programCount) {
+            if (importedPath == path) {
+                qInfo().noquote() << i18n("Imported %1 programs from %2", programCount, path);
+            }
+        });
+        fetcher.importFile(path);
+    }
+    if (parser.isSet(m_refreshFavoritesOption)) {
+        fetcher.fetchFavorites();
+    }
+    waitUntilIdle();
+    saveMetrics(parser);
+
+    QTextStream out(stdout);
+    out.setCodec("UTF-8");
+    if (parser.isSet(m_queryOption) && !query(ChannelId(parser.value(m_queryOption)), parser.positionalArguments(), out)) {
+        return 1;
+    }
+    if (parser.isSet(m_exportOption)) {
+        exportXmlTv(out);
+    }
+
+    return m_errors > 0 ? 1 : 0;
+}
+
+void Headless::saveMetrics(const QCommandLineParser &parser) const
+{
+    if (parser.isSet(m_metricsOption)) {
+        FetchMetrics::instance().saveJson(parser.value(m_metricsOption));
+    }
+}
+
+void Headless::waitUntilIdle()
+{
+    // results arrive via the event loop, the fetcher is done when nothing is running anymore
+    QEventLoop loop;
+    QTimer timer;
+    timer.setInterval(IDLE_CHECK_INTERVAL);
+    connect(&timer, &QTimer::timeout, &loop, [&loop]() {
+        if (Fetcher::instance().isIdle()) {
+            loop.quit();
+        }
+    });
+    timer.start();
+    loop.exec();
+}
+
+bool Headless::query(const ChannelId &channelId, const QStringList &range, QTextStream &out) const
+{
+    const QDateTime from = range.size() > 0 ? QDateTime::fromString(range.at(0), Qt::ISODate) : QDateTime::currentDateTime();
+    const QDateTime to = range.size() > 1 ? QDateTime::fromString(range.at(1), Qt::ISODate) : from.addDays(1);
+    if (!from.isValid() || !to.isValid()) {
+        qWarning().noquote() << i18n("Invalid time range (expected ISO 8601, e.g. 2020-12-24T20:15)");
+        return false;
+    }
+
+    const QVector<ProgramData> programs = Database::instance().programs(channelId);
+    if (programs.isEmpty()) {
+        qWarning().noquote() << i18n("No programs for channel %1", channelId.value());
+        return false;
+    }
+    for (const ProgramData &program : programs) {
+        if (program.m_stopTime <= from || program.m_startTime >= to) {
+            continue;
+        }
+        out << program.m_startTime.toString(Qt::ISODate) << '\t' << program.m_stopTime.toString(Qt::ISODate) << '\t' << program.m_title;
+        if (!program.m_subtitle.isEmpty()) {
+            out << '\t' << program.m_subtitle;
+        }
+        out << '\n';
+    }
+    return true;
+}
+
+void Headless::exportXmlTv(QTextStream &out) const
+{
+    QString xml;
+    QXmlStreamWriter writer(&xml);
+    writer.setAutoFormatting(true);
+    writer.writeStartDocument();
+    writer.writeStartElement(QStringLiteral("tv"));
+    writer.writeAttribute(QStringLiteral("generator-info-name"), QStringLiteral("telly-skout"));
+
+    const QVector<ChannelData> channels = Database::instance().channels(true);
+    for (const ChannelData &channel : channels) {
+        writer.writeStartElement(QStringLiteral("channel"));
+        writer.writeAttribute(QStringLiteral("id"), channel.m_id.value());
+        writer.writeTextElement(QStringLiteral("display-name"), channel.m_name);
+        if (!channel.m_image.isEmpty()) {
+            writer.writeEmptyElement(QStringLiteral("icon"));
+            writer.writeAttribute(QStringLiteral("src"), channel.m_image);
+        }
+        writer.writeEndElement();
+    }
+
+    for (const ChannelData &channel : channels) {
+        const QVector<ProgramData> programs = Database::instance().programs(channel.m_id);
+        for (const ProgramData &program : programs) {
+            writer.writeStartElement(QStringLiteral("programme"));
+            writer.writeAttribute(QStringLiteral("start"), program.m_startTime.toUTC().toString(XMLTV_TIME_FORMAT) + QStringLiteral(" +0000"));
+            writer.writeAttribute(QStringLiteral("stop"), program.m_stopTime.toUTC().toString(XMLTV_TIME_FORMAT) + QStringLiteral(" +0000"));
+            writer.writeAttribute(QStringLiteral("channel"), channel.m_id.value());
+            writer.writeTextElement(QStringLiteral("title"), program.m_title);
+            if (!program.m_subtitle.isEmpty()) {
+                writer.writeTextElement(QStringLiteral("sub-title"), program.m_subtitle);
+            }
+            if (!program.m_description.isEmpty()) {
+                writer.writeTextElement(QStringLiteral("desc"), program.m_description);
+            }
+            if (!program.m_category.isEmpty()) {
+                writer.writeTextElement(QStringLiteral("category"), program.m_category);
+            }
+            writer.writeEndElement();
+        }
+        // do not keep the whole export in memory
+        out << xml;
+        xml.clear();
+    }
+
+    writer.writeEndElement();
+    writer.writeEndDocument();
+    out << xml;
+}
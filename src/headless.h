@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QObject>
+
+#include "types.h"
+
+#include <QCommandLineOption>
+#include <QString>
+#include <QStringList>
+
+class QCommandLineParser;
+class QTextStream;
+
+// command line mode without GUI (e.g. cron job which refreshes the favorites)
+// runs on a QCoreApplication, i.e. no display or GPU is required
+class Headless : public QObject
+{
+    Q_OBJECT
+
+public:
+    Headless();
+
+    void addOptions(QCommandLineParser &parser) const;
+    static bool isRequested(int argc, char *argv[]); // before the application exists (decides which one is created)
+
+    int exec(const QCommandLineParser &parser); // returns the exit code
+
+private:
+    void saveMetrics(const QCommandLineParser &parser) const;
+    void waitUntilIdle();
+    bool query(const ChannelId &channelId, const QStringList &range, QTextStream &out) const;
+    void exportXmlTv(QTextStream &out) const;
+
+    QCommandLineOption m_refreshFavoritesOption;
+    QCommandLineOption m_importOption;
+    QCommandLineOption m_queryOption;
+    QCommandLineOption m_exportOption;
+    QCommandLineOption m_benchmarkXmlTvOption;
+    QCommandLineOption m_metricsOption;
+
+    int m_errors = 0;
+};
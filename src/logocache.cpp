@@ -0,0 +1,357 @@
+#include "logocache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QMutexLocker>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+
+namespace
+{
+const qint64 MAX_SIZE = 50 * 1024 * 1024; // [bytes]
+// evict a bit more than necessary such that not every insert evicts
+const qint64 EVICT_TO_SIZE = MAX_SIZE * 9 / 10;
+// logos up to this size go into the pack file
+const qint64 MAX_PACKED_SIZE = 16 * 1024;
+// rewrite the pack file if that much of it belongs to evicted logos
+const qint64 MIN_DEAD_PACK_BYTES = 1024 * 1024;
+
+const quint32 INDEX_VERSION = 1;
+const int SAVE_INDEX_DELAY = 2000; // [ms]
+}
+
+LogoCache::LogoCache()
+    : QObject(nullptr)
+{
+    m_directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/logos");
+    QDir().mkpath(m_directory);
+
+    m_manager = new QNetworkAccessManager(this);
+    m_manager->setRedirectPolicy(QNetworkRequest::NoLessSafeRedirectPolicy);
+    m_manager->setStrictTransportSecurityEnabled(true);
+    m_manager->enableStrictTransportSecurityStore(true);
+
+    // the index is written with a delay (access times change on every lookup)
+    m_saveTimer.setSingleShot(true);
+    m_saveTimer.setInterval(SAVE_INDEX_DELAY);
+    connect(&m_saveTimer, &QTimer::timeout, this, &LogoCache::saveIndex);
+
+    loadIndex();
+    removeLegacyFiles();
+}
+
+LogoCache::~LogoCache()
+{
+    saveIndex();
+}
+
+bool LogoCache::lookup(const QString &url, QByteArray &data)
+{
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_entries.find(key(url));
+    if (it == m_entries.end()) {
+        return false;
+    }
+
+    QFile file(it->m_packed ? packPath() : filePath(it.key()));
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(it->m_offset) || (data = file.read(it->m_size)).size() != it->m_size) {
+        qWarning() << "Failed to read cached logo" << url;
+        m_size -= it->m_size;
+        if (it->m_packed) {
+            m_deadPackBytes += it->m_size;
+        }
+        m_entries.erase(it);
+        setIndexDirty();
+        return false;
+    }
+
+    it->m_lastAccess = ++m_accessCounter;
+    setIndexDirty();
+    return true;
+}
+
+void LogoCache::fetch(const QString &url, const Callback &callback)
+{
+    QByteArray data;
+    if (lookup(url, data)) {
+        callback(data);
+        return;
+    }
+
+    // only one download per logo
+    const bool running = m_downloads.contains(url);
+    m_downloads[url].append(callback);
+    if (!running) {
+        download(url);
+    }
+}
+
+qint64 LogoCache::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_size;
+}
+
+QByteArray LogoCache::key(const QString &url)
+{
+    return QCryptographicHash::hash(url.toUtf8(), QCryptographicHash::Md5);
+}
+
+QString LogoCache::filePath(const QByteArray &key) const
+{
+    return m_directory + QStringLiteral("/") + QString::fromLatin1(key.toHex());
+}
+
+QString LogoCache::packPath() const
+{
+    return m_directory + QStringLiteral("/logos.pack");
+}
+
+QString LogoCache::indexPath() const
+{
+    return m_directory + QStringLiteral("/logos.index");
+}
+
+void LogoCache::download(const QString &url)
+{
+    qDebug() << "Download logo" << url;
+
+    QNetworkRequest request((QUrl(url)));
+    request.setRawHeader("User-Agent", "telly-skout/0.1");
+    QNetworkReply *reply = m_manager->get(request);
+    connect(reply, &QNetworkReply::finished, this, [this, url, reply]() {
+        QByteArray data;
+        if (reply->error() == QNetworkReply::NoError) {
+            data = reply->readAll();
+            insert(url, data);
+        } else {
+            qWarning() << "Failed to download logo" << url << ":" << reply->errorString();
+        }
+        reply->deleteLater();
+
+        const QVector<Callback> callbacks = m_downloads.take(url);
+        for (const Callback &callback : callbacks) {
+            callback(data);
+        }
+    });
+}
+
+void LogoCache::insert(const QString &url, const QByteArray &data)
+{
+    if (data.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    const QByteArray entryKey = key(url);
+
+    // replaced (e.g. downloaded again): release the old data
+    const auto existing = m_entries.find(entryKey);
+    if (existing != m_entries.end()) {
+        m_size -= existing->m_size;
+        if (existing->m_packed) {
+            m_deadPackBytes += existing->m_size;
+        } else {
+            QFile::remove(filePath(entryKey));
+        }
+        m_entries.erase(existing);
+        setIndexDirty();
+    }
+
+    Entry entry;
+    entry.m_size = data.size();
+    entry.m_lastAccess = ++m_accessCounter;
+    entry.m_packed = data.size() <= MAX_PACKED_SIZE;
+
+    QFile file(entry.m_packed ? packPath() : filePath(entryKey));
+    if (!file.open(entry.m_packed ? QIODevice::Append : QIODevice::WriteOnly)) {
+        qWarning() << "Failed to cache logo" << url << ":" << file.errorString();
+        return;
+    }
+    entry.m_offset = entry.m_packed ? file.size() : 0;
+    if (file.write(data) != data.size()) {
+        qWarning() << "Failed to cache logo" << url << ":" << file.errorString();
+        return;
+    }
+    if (entry.m_packed) {
+        m_packSize = entry.m_offset + entry.m_size;
+    }
+
+    m_entries.insert(entryKey, entry);
+    m_size += entry.m_size;
+    setIndexDirty();
+
+    evict();
+}
+
+void LogoCache::evict()
+{
+    if (m_size <= MAX_SIZE) {
+        return;
+    }
+
+    // least recently used first
+    QVector<QPair<quint64, QByteArray>> entries;
+    entries.reserve(m_entries.size());
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        entries.append(qMakePair(it->m_lastAccess, it.key()));
+    }
+    std::sort(entries.begin(), entries.end());
+
+    for (int i = 0; i < entries.size() && m_size > EVICT_TO_SIZE; ++i) {
+        const Entry entry = m_entries.take(entries.at(i).second);
+        m_size -= entry.m_size;
+        if (entry.m_packed) {
+            m_deadPackBytes += entry.m_size;
+        } else {
+            QFile::remove(filePath(entries.at(i).second));
+        }
+    }
+    qDebug() << "Evicted logos, cache size now" << m_size << "bytes";
+
+    if (m_deadPackBytes >= MIN_DEAD_PACK_BYTES && m_deadPackBytes * 2 >= m_packSize) {
+        compactPack();
+    }
+}
+
+void LogoCache::compactPack()
+{
+    QFile pack(packPath());
+    QSaveFile compacted(packPath());
+    if (!pack.open(QIODevice::ReadOnly) || !compacted.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to compact logo pack";
+        return;
+    }
+
+    QHash<QByteArray, qint64> offsets;
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        if (!it->m_packed) {
+            continue;
+        }
+        pack.seek(it->m_offset);
+        offsets.insert(it.key(), compacted.pos());
+        compacted.write(pack.read(it->m_size));
+    }
+    pack.close();
+
+    const qint64 packSize = compacted.pos();
+    if (!compacted.commit()) {
+        qWarning() << "Failed to compact logo pack";
+        return;
+    }
+
+    for (auto it = offsets.constBegin(); it != offsets.constEnd(); ++it) {
+        m_entries[it.key()].m_offset = it.value();
+    }
+    m_packSize = packSize;
+    m_deadPackBytes = 0;
+
+    // the old offsets do not match the pack file anymore
+    m_indexDirty = true;
+    writeIndex();
+}
+
+void LogoCache::loadIndex()
+{
+    QMutexLocker locker(&m_mutex);
+
+    QFile file(indexPath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QDataStream stream(&file);
+    quint32 version = 0;
+    stream >> version;
+    if (version != INDEX_VERSION) {
+        qWarning() << "Unknown logo index version" << version;
+        return;
+    }
+
+    qint32 count = 0;
+    stream >> count >> m_accessCounter;
+    qint64 packedSize = 0;
+    for (qint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QByteArray entryKey;
+        Entry entry;
+        stream >> entryKey >> entry.m_packed >> entry.m_offset >> entry.m_size >> entry.m_lastAccess;
+        m_entries.insert(entryKey, entry);
+        m_size += entry.m_size;
+        if (entry.m_packed) {
+            packedSize += entry.m_size;
+        }
+    }
+    if (stream.status() != QDataStream::Ok) {
+        qWarning() << "Corrupt logo index";
+        m_entries.clear();
+        m_size = 0;
+        packedSize = 0;
+    }
+
+    m_packSize = QFile(packPath()).size();
+    m_deadPackBytes = m_packSize - packedSize;
+}
+
+void LogoCache::saveIndex()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_indexDirty) {
+        writeIndex();
+    }
+}
+
+void LogoCache::setIndexDirty()
+{
+    if (!m_indexDirty) {
+        m_indexDirty = true;
+        // may be called from any thread, the timer lives in the GUI thread
+        QMetaObject::invokeMethod(
+            this,
+            [this]() {
+                if (!m_saveTimer.isActive()) {
+                    m_saveTimer.start();
+                }
+            },
+            Qt::QueuedConnection);
+    }
+}
+
+void LogoCache::writeIndex()
+{
+    QSaveFile file(indexPath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to save logo index:" << file.errorString();
+        return;
+    }
+    QDataStream stream(&file);
+    stream << INDEX_VERSION << static_cast<qint32>(m_entries.size()) << m_accessCounter;
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        stream << it.key() << it->m_packed << it->m_offset << it->m_size << it->m_lastAccess;
+    }
+    if (file.commit()) {
+        m_indexDirty = false;
+    }
+}
+
+void LogoCache::removeLegacyFiles()
+{
+    // logos used to be stored with the MD5 of the URL as name in the app data directory
+    const QString legacyDirectory = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    const QRegularExpression legacyName(QStringLiteral("^[0-9a-f]{32}$"));
+    const QStringList files = QDir(legacyDirectory).entryList(QDir::Files);
+    for (const QString &fileName : files) {
+        if (legacyName.match(fileName).hasMatch()) {
+            QFile::remove(legacyDirectory + QStringLiteral("/") + fileName);
+        }
+    }
+}
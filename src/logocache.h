@@ -0,0 +1,77 @@
+#pragma once
+
+#include <QObject>
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+
+#include <functional>
+
+class QNetworkAccessManager;
+
+// disk cache for channel logos
+// - in-memory index (no file system access to find out if a logo is cached)
+// - size limit, least recently used logos are evicted
+// - small logos share a pack file (instead of one file each)
+// lookup() and insert() may be called from any thread, everything else only from the GUI thread
+class LogoCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static LogoCache &instance()
+    {
+        static LogoCache _instance;
+        return _instance;
+    }
+
+    using Callback = std::function<void(const QByteArray &data)>; // empty data if the logo is not available
+
+    bool lookup(const QString &url, QByteArray &data);
+    void fetch(const QString &url, const Callback &callback); // lookup + download if not cached
+    void insert(const QString &url, const QByteArray &data); // any thread (e.g. derived data like rendered logos)
+
+    qint64 size() const;
+
+private:
+    LogoCache();
+    ~LogoCache();
+
+    struct Entry {
+        bool m_packed = false; // in the pack file (else own file)
+        qint64 m_offset = 0; // in the pack file
+        qint64 m_size = 0;
+        quint64 m_lastAccess = 0;
+    };
+
+    static QByteArray key(const QString &url);
+    QString filePath(const QByteArray &key) const;
+    QString packPath() const;
+    QString indexPath() const;
+
+    void download(const QString &url);
+    void evict(); // m_mutex must be locked
+    void compactPack(); // m_mutex must be locked
+    void loadIndex();
+    void saveIndex();
+    void setIndexDirty(); // m_mutex must be locked
+    void writeIndex(); // m_mutex must be locked
+    void removeLegacyFiles();
+
+    QString m_directory;
+    QNetworkAccessManager *m_manager;
+    QHash<QString, QVector<Callback>> m_downloads; // running downloads (URL -> waiting callbacks)
+
+    mutable QMutex m_mutex; // protects everything below
+    QHash<QByteArray, Entry> m_entries;
+    quint64 m_accessCounter = 0;
+    qint64 m_size = 0; // of all entries
+    qint64 m_packSize = 0;
+    qint64 m_deadPackBytes = 0; // evicted entries in the pack file
+    bool m_indexDirty = false;
+    QTimer m_saveTimer;
+};
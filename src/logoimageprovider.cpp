@@ -0,0 +1,140 @@
+#include "logoimageprovider.h"
+
+#include "logocache.h"
+
+#include <QBuffer>
+#include <QDebug>
+#include <QImage>
+#include <QImageReader>
+#include <QPainter>
+#include <QQuickImageResponse>
+#include <QQuickTextureFactory>
+#include <QSvgRenderer>
+#include <QThreadPool>
+#include <QUrl>
+
+namespace
+{
+// logos are rasterized at the requested size, larger ones would not fit into the texture atlas of the scene graph
+const QSize DEFAULT_SIZE(64, 64);
+const QSize MAX_SIZE(256, 256);
+
+class LogoImageResponse : public QQuickImageResponse
+{
+public:
+    LogoImageResponse(const QString &url, const QSize &requestedSize)
+        : m_url(url)
+        , m_size(requestedSize.isEmpty() ? DEFAULT_SIZE : requestedSize.boundedTo(MAX_SIZE))
+        , m_renderedKey(url + QStringLiteral("#") + QString::number(m_size.width()) + QStringLiteral("x") + QString::number(m_size.height()))
+    {
+        // the engine keeps the response until finished() is emitted (also if it is cancelled)
+        QThreadPool::globalInstance()->start([this]() {
+            // rendered at this size before: only a small PNG to decode
+            QByteArray data;
+            if (LogoCache::instance().lookup(m_renderedKey, data) && m_image.loadFromData(data, "PNG")) {
+                Q_EMIT finished();
+                return;
+            }
+
+            if (LogoCache::instance().lookup(m_url, data)) {
+                render(data);
+                return;
+            }
+            // download on the GUI thread (owns the network access manager), render on the thread pool again
+            QMetaObject::invokeMethod(
+                &LogoCache::instance(),
+                [this]() {
+                    LogoCache::instance().fetch(m_url, [this](const QByteArray &data) {
+                        QThreadPool::globalInstance()->start([this, data]() {
+                            render(data);
+                        });
+                    });
+                },
+                Qt::QueuedConnection);
+        });
+    }
+
+    QQuickTextureFactory *textureFactory() const override
+    {
+        // small images end up in the shared texture atlas of the scene graph
+        return QQuickTextureFactory::textureFactoryForImage(m_image);
+    }
+
+    QString errorString() const override
+    {
+        return m_errorString;
+    }
+
+private:
+    // worker thread
+    void render(const QByteArray &data)
+    {
+        if (data.isEmpty()) {
+            m_errorString = QStringLiteral("Logo not available: ") + m_url;
+        } else if (isSvg(data)) {
+            renderSvg(data);
+        } else {
+            decode(data);
+        }
+
+        if (!m_image.isNull()) {
+            QByteArray png;
+            QBuffer buffer(&png);
+            buffer.open(QIODevice::WriteOnly);
+            if (m_image.save(&buffer, "PNG")) {
+                LogoCache::instance().insert(m_renderedKey, png);
+            }
+        }
+        Q_EMIT finished();
+    }
+
+    static bool isSvg(const QByteArray &data)
+    {
+        // e.g. xmltv.se logos (full vector graphics)
+        const QByteArray start = data.left(256);
+        return start.contains("<svg") || (start.startsWith("<?xml") && data.contains("<svg"));
+    }
+
+    void renderSvg(const QByteArray &data)
+    {
+        QSvgRenderer renderer(data);
+        if (!renderer.isValid()) {
+            m_errorString = QStringLiteral("Invalid SVG logo: ") + m_url;
+            return;
+        }
+        QSize size = renderer.defaultSize();
+        size = size.isEmpty() ? m_size : size.scaled(m_size, Qt::KeepAspectRatio);
+
+        m_image = QImage(size, QImage::Format_ARGB32_Premultiplied);
+        m_image.fill(Qt::transparent);
+        QPainter painter(&m_image);
+        renderer.render(&painter);
+    }
+
+    void decode(const QByteArray &data)
+    {
+        QBuffer buffer;
+        buffer.setData(data);
+        QImageReader reader(&buffer);
+        // decode at the target size instead of scaling the full image afterwards
+        if (reader.size().isValid()) {
+            reader.setScaledSize(reader.size().scaled(m_size, Qt::KeepAspectRatio));
+        }
+        if (!reader.read(&m_image)) {
+            m_errorString = reader.errorString();
+            qWarning() << "Failed to decode logo" << m_url << ":" << m_errorString;
+        }
+    }
+
+    const QString m_url;
+    const QSize m_size;
+    const QString m_renderedKey;
+    QImage m_image;
+    QString m_errorString;
+};
+}
+
+QQuickImageResponse *LogoImageProvider::requestImageResponse(const QString &id, const QSize &requestedSize)
+{
+    return new LogoImageResponse(QUrl::fromPercentEncoding(id.toUtf8()), requestedSize);
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <QQuickAsyncImageProvider>
+
+// image://logo/<percent encoded URL>
+// logos are served from the LogoCache (downloaded if necessary) without blocking the GUI or render thread
+// they are rasterized (also SVGs) at the requested size on a worker thread, the result is cached as PNG
+class LogoImageProvider : public QQuickAsyncImageProvider
+{
+public:
+    QQuickImageResponse *requestImageResponse(const QString &id, const QSize &requestedSize) override;
+};
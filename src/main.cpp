@@ -2,11 +2,19 @@
 #include "channelsmodel.h"
 #include "channelsproxymodel.h"
 #include "countriesmodel.h"
-#include "database.h"
+#include "epggriditem.h"
+#include "epggridmodel.h"
 #include "fetcher.h"
+#include "fetchmetrics.h"
+#include "headless.h"
+#include "logocache.h"
+#include "logoimageprovider.h"
+#include "nownextmodel.h"
+#include "parserpool.h"
 #include "programsmodel.h"
-#include "programsproxymodel.h"
+#include "startup.h"
 #include "telly-skout-version.h"
+#include "tracer.h"
 
 #include <KAboutData>
 #include <KLocalizedContext>
@@ -15,6 +23,7 @@
 #include <QCommandLineParser>
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
+#include <QQuickWindow>
 #include <QQuickStyle>
 #include <QString>
 
@@ -28,66 +37,125 @@
 Q_DECL_EXPORT
 #endif
 
-int main(int argc, char *argv[])
+static void setupApplication()
 {
-    QApplication app(argc, argv);
-    if (qEnvironmentVariableIsEmpty("QT_QUICK_CONTROLS_STYLE")) {
-        QQuickStyle::setStyle(QStringLiteral("org.kde.desktop"));
-    }
-
     // about
     QCoreApplication::setOrganizationName(QStringLiteral("KDE"));
     QCoreApplication::setOrganizationDomain(QStringLiteral("kde.org"));
     QCoreApplication::setApplicationName(QStringLiteral("Telly Skout"));
-
-    const QString applicationDescription = i18n("Convergent EPG based on Kirigami");
+    KLocalizedString::setApplicationDomain("telly-skout");
 
     KAboutData about(QStringLiteral("telly-skout"),
                      i18n("Telly Skout"),
                      QStringLiteral(TELLY_SKOUT_VERSION_STRING),
-                     applicationDescription,
+                     i18n("Convergent EPG based on Kirigami"),
                      KAboutLicense::GPL,
                      i18n("© 2020 KDE Community"));
     about.addAuthor("Plata", QString(), QStringLiteral("plata@example.com"));
     KAboutData::setApplicationData(about);
+}
 
-    // command line parser
-    QCommandLineParser parser;
-    parser.setApplicationDescription(applicationDescription);
+static QCommandLineOption traceOption()
+{
+    return QCommandLineOption(QStringLiteral("trace"), i18n("Write a Chrome trace (see ui.perfetto.dev) to the file on exit."), QStringLiteral("file"));
+}
+
+static void setupParser(QCommandLineParser &parser, const Headless &headless)
+{
+    parser.setApplicationDescription(KAboutData::applicationData().shortDescription());
     parser.addHelpOption();
     parser.addVersionOption();
+    parser.addOption(traceOption());
+    headless.addOptions(parser);
+}
+
+static void startTracing(const QCommandLineParser &parser)
+{
+    const QString path = parser.isSet(traceOption()) ? parser.value(traceOption()) : qEnvironmentVariable("TELLY_SKOUT_TRACE");
+    if (!path.isEmpty()) {
+        Tracer::instance().start(path);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    Startup::instance().mark(QStringLiteral("main"));
+
+    // command line mode: QCoreApplication only (fast startup, no display required)
+    if (Headless::isRequested(argc, argv)) {
+        QCoreApplication app(argc, argv);
+        setupApplication();
+
+        Headless headless;
+        QCommandLineParser parser;
+        setupParser(parser, headless);
+        parser.process(app);
+        startTracing(parser);
+
+        const int result = headless.exec(parser);
+        Tracer::instance().stop();
+        return result;
+    }
+
+    QApplication app(argc, argv);
+    if (qEnvironmentVariableIsEmpty("QT_QUICK_CONTROLS_STYLE")) {
+        QQuickStyle::setStyle(QStringLiteral("org.kde.desktop"));
+    }
+
+    setupApplication();
+    Startup::instance().mark(QStringLiteral("application created"));
+
+    // command line parser (headless options are listed in --help)
+    Headless headless;
+    QCommandLineParser parser;
+    setupParser(parser, headless);
     parser.process(app);
+    startTracing(parser);
 
     // register qml types
     qmlRegisterType<CountriesModel>("org.kde.TellySkout", 1, 0, "CountriesModel");
     qmlRegisterType<ChannelsModel>("org.kde.TellySkout", 1, 0, "ChannelsModel");
     qmlRegisterType<ChannelsProxyModel>("org.kde.TellySkout", 1, 0, "ChannelsProxyModel");
-    qmlRegisterType<ProgramsProxyModel>("org.kde.TellySkout", 1, 0, "ProgramsProxyModel");
+    qmlRegisterType<EpgGridModel>("org.kde.TellySkout", 1, 0, "EpgGridModel");
+    qmlRegisterType<EpgGridItem>("org.kde.TellySkout", 1, 0, "EpgGrid");
+    qmlRegisterType<NowNextModel>("org.kde.TellySkout", 1, 0, "NowNextModel");
 
     qmlRegisterUncreatableType<ProgramsModel>("org.kde.TellySkout", 1, 0, "ProgramsModel", QStringLiteral("Get from Channel"));
 
     qmlRegisterSingletonInstance("org.kde.TellySkout", 1, 0, "Fetcher", &Fetcher::instance());
+    qmlRegisterSingletonInstance("org.kde.TellySkout", 1, 0, "FetchMetrics", &FetchMetrics::instance());
 
     // setup engine
     QQmlApplicationEngine engine;
     engine.rootContext()->setContextObject(new KLocalizedContext(&engine));
-    KLocalizedString::setApplicationDomain("telly-skout");
+    engine.addImageProvider(QStringLiteral("logo"), new LogoImageProvider);
 
-    engine.rootContext()->setContextProperty(QStringLiteral("_aboutData"), QVariant::fromValue(about));
+    engine.rootContext()->setContextProperty(QStringLiteral("_aboutData"), QVariant::fromValue(KAboutData::applicationData()));
 
     TellySkoutSettings settings;
 
     engine.rootContext()->setContextProperty(QStringLiteral("_settings"), &settings);
 
     QObject::connect(&app, &QCoreApplication::aboutToQuit, &settings, &TellySkoutSettings::save);
+    QObject::connect(&app, &QCoreApplication::aboutToQuit, &ParserPool::instance(), &ParserPool::cancelAll);
+    QObject::connect(&app, &QCoreApplication::aboutToQuit, &Tracer::instance(), &Tracer::stop);
 
-    Database::instance();
+    LogoCache::instance(); // must live in the GUI thread (used by the image provider threads)
 
+    // the database is opened after the window is shown (see Startup)
     engine.load(QUrl(QStringLiteral("qrc:///main.qml")));
 
     if (engine.rootObjects().isEmpty()) {
         return -1;
     }
+    Startup::instance().mark(QStringLiteral("QML loaded"));
+
+    QQuickWindow *window = qobject_cast<QQuickWindow *>(engine.rootObjects().first());
+    if (window) {
+        Startup::instance().openDatabaseAfterFirstFrame(window);
+    } else {
+        Startup::instance().openDatabase();
+    }
 
     return app.exec();
 }
@@ -1,8 +1,17 @@
 #include "networkfetcher.h"
 
+#include "fetchmetrics.h"
+#include "tracer.h"
+
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QNetworkRequest>
+#include <QUrl>
+
+namespace
+{
+QUrl urlOverride; // GUI thread only
+}
 
 NetworkFetcher::NetworkFetcher()
 {
@@ -12,8 +21,38 @@ NetworkFetcher::NetworkFetcher()
     m_manager->enableStrictTransportSecurityStore(true);
 }
 
-QNetworkReply *NetworkFetcher::get(QNetworkRequest &request)
+bool NetworkFetcher::isBusy() const
+{
+    return m_pendingReplies > 0;
+}
+
+void NetworkFetcher::setUrlOverride(const QUrl &url)
+{
+    urlOverride = url;
+}
+
+QNetworkReply *NetworkFetcher::get(QNetworkRequest &request, const ChannelId &channelId)
 {
     request.setRawHeader("User-Agent", "telly-skout/0.1");
-    return m_manager->get(request);
+    if (urlOverride.isValid()) {
+        // e.g. https://www.tvspielfilm.de/a?b -> http://127.0.0.1:1234/www.tvspielfilm.de/a?b
+        const QUrl original = request.url();
+        QUrl url = urlOverride;
+        url.setPath(QStringLiteral("/") + original.host() + original.path());
+        url.setQuery(original.query(QUrl::FullyEncoded));
+        request.setUrl(url);
+    }
+    QNetworkReply *reply = m_manager->get(request);
+    FetchMetrics::instance().requestStarted(reply, name(), channelId);
+    if (Tracer::isEnabled()) {
+        const qint64 start = Tracer::instance().now();
+        connect(reply, &QNetworkReply::finished, this, [reply, start]() {
+            Tracer::instance().async("network", "GET", reinterpret_cast<quintptr>(reply), start, reply->url().toString());
+        });
+    }
+    ++m_pendingReplies;
+    connect(reply, &QObject::destroyed, this, [this]() {
+        --m_pendingReplies;
+    });
+    return reply;
 }
@@ -13,14 +13,22 @@ public:
     NetworkFetcher();
     virtual ~NetworkFetcher() = default;
 
+    QString name() const override = 0;
+    bool handlesUrl(const QUrl &url) const override = 0;
+    bool isBusy() const override;
+
+    // sends all requests to this server instead (e.g. ReplayServer), the original host is the first path segment
+    static void setUrlOverride(const QUrl &url);
+
     void fetchCountries() override = 0;
     void fetchCountry(const QString &url, const CountryId &countryId) override = 0;
-    void fetchProgram(const ChannelId &channelId) override = 0;
+    void fetchProgram(const ChannelId &channelId, const ChannelId &providerChannelId, const QVector<QDate> &days) override = 0;
     void fetchProgramDescription(const ChannelId &channelId, const ProgramId &programId, const QString &url) override = 0;
 
 protected:
-    QNetworkReply *get(QNetworkRequest &request);
+    QNetworkReply *get(QNetworkRequest &request, const ChannelId &channelId = ChannelId()); // channelId for the metrics
 
 private:
     QNetworkAccessManager *m_manager;
+    int m_pendingReplies = 0; // not deleted yet (i.e. maybe still processed)
 };
@@ -0,0 +1,270 @@
+#include "nownextmodel.h"
+
+#include "channel.h"
+#include "channelsmodel.h"
+#include "programsmodel.h"
+#include "tracer.h"
+
+#include <QDateTime>
+
+#include <algorithm>
+#include <limits>
+
+NowNextModel::NowNextModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+    // boundaries are exact minutes usually, a coarse timer would be late by minutes for long programs
+    m_boundaryTimer.setSingleShot(true);
+    m_boundaryTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_boundaryTimer, &QTimer::timeout, this, &NowNextModel::updateAll);
+}
+
+QVariant NowNextModel::data(const QModelIndex &index, int role) const
+{
+    if (!m_channelsModel || !index.isValid() || index.row() >= m_entries.size()) {
+        return QVariant();
+    }
+    const Entry &entry = m_entries.at(index.row());
+
+    switch (role) {
+    case ChannelRole:
+        return m_channelsModel->data(m_channelsModel->index(index.row(), 0), ChannelsModel::ChannelRole);
+    case NowAvailableRole:
+        return entry.m_hasNow;
+    case NowIdRole:
+        return entry.m_hasNow ? entry.m_now.m_id.value() : QString();
+    case NowTitleRole:
+        return entry.m_hasNow ? entry.m_now.m_title : QString();
+    case NowStartRole:
+        return entry.m_hasNow ? entry.m_now.m_start * 1000 : 0;
+    case NowStopRole:
+        return entry.m_hasNow ? entry.m_now.m_stop * 1000 : 0;
+    case NowStartTextRole:
+        return entry.m_hasNow ? entry.m_now.m_startText : QString();
+    case NowStopTextRole:
+        return entry.m_hasNow ? entry.m_now.m_stopText : QString();
+    case NextAvailableRole:
+        return entry.m_hasNext;
+    case NextTitleRole:
+        return entry.m_hasNext ? entry.m_next.m_title : QString();
+    case NextStartRole:
+        return entry.m_hasNext ? entry.m_next.m_start * 1000 : 0;
+    case NextStartTextRole:
+        return entry.m_hasNext ? entry.m_next.m_startText : QString();
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> NowNextModel::roleNames() const
+{
+    QHash<int, QByteArray> roleNames;
+    roleNames[ChannelRole] = "channel";
+    roleNames[NowAvailableRole] = "nowAvailable";
+    roleNames[NowIdRole] = "nowId";
+    roleNames[NowTitleRole] = "nowTitle";
+    roleNames[NowStartRole] = "nowStart";
+    roleNames[NowStopRole] = "nowStop";
+    roleNames[NowStartTextRole] = "nowStartText";
+    roleNames[NowStopTextRole] = "nowStopText";
+    roleNames[NextAvailableRole] = "nextAvailable";
+    roleNames[NextTitleRole] = "nextTitle";
+    roleNames[NextStartRole] = "nextStart";
+    roleNames[NextStartTextRole] = "nextStartText";
+    return roleNames;
+}
+
+int NowNextModel::rowCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent)
+    return m_entries.size();
+}
+
+ChannelsModel *NowNextModel::channelsModel() const
+{
+    return m_channelsModel;
+}
+
+void NowNextModel::setChannelsModel(ChannelsModel *channelsModel)
+{
+    if (m_channelsModel == channelsModel) {
+        return;
+    }
+    if (m_channelsModel) {
+        disconnect(m_channelsModel, nullptr, this, nullptr);
+    }
+    m_channelsModel = channelsModel;
+
+    if (m_channelsModel) {
+        connect(m_channelsModel, &QAbstractItemModel::modelReset, this, &NowNextModel::reset);
+        connect(m_channelsModel, &QAbstractItemModel::rowsInserted, this, &NowNextModel::onRowsInserted);
+        connect(m_channelsModel, &QAbstractItemModel::rowsRemoved, this, &NowNextModel::onRowsRemoved);
+        connect(m_channelsModel, &QAbstractItemModel::rowsMoved, this, &NowNextModel::onRowsMoved);
+        connect(m_channelsModel, &QObject::destroyed, this, &NowNextModel::reset);
+    }
+    reset();
+    Q_EMIT channelsModelChanged();
+}
+
+NowNextModel::Entry NowNextModel::createEntry(int row) const
+{
+    Entry entry;
+    Channel *channel = m_channelsModel->data(m_channelsModel->index(row, 0), ChannelsModel::ChannelRole).value<Channel *>();
+    if (channel) {
+        entry.m_programsModel = channel->programsModel();
+        updateEntry(entry, QDateTime::currentMSecsSinceEpoch());
+    }
+    return entry;
+}
+
+void NowNextModel::connectEntry(const Entry &entry)
+{
+    ProgramsModel *programsModel = entry.m_programsModel;
+    if (!programsModel) {
+        return;
+    }
+    const auto update = [this, programsModel]() {
+        updateChannel(programsModel);
+    };
+    connect(programsModel, &QAbstractItemModel::modelReset, this, update);
+    connect(programsModel, &QAbstractItemModel::rowsInserted, this, update);
+    connect(programsModel, &QAbstractItemModel::rowsRemoved, this, update);
+    connect(programsModel, &QAbstractItemModel::dataChanged, this, update);
+}
+
+bool NowNextModel::updateEntry(Entry &entry, qint64 now) const
+{
+    bool hasNow = false;
+    bool hasNext = false;
+    ProgramRowData current;
+    ProgramRowData next;
+
+    if (entry.m_programsModel) {
+        const QVector<ProgramRowData> &programs = entry.m_programsModel->programs();
+        const qint64 nowS = now / 1000;
+        auto it = ProgramsModel::firstNotEnded(programs, nowS);
+        if (it != programs.end() && it->m_start <= nowS) {
+            hasNow = true;
+            current = *it;
+            ++it;
+        }
+        if (it != programs.end()) {
+            hasNext = true;
+            next = *it;
+        }
+    }
+
+    const bool changed = hasNow != entry.m_hasNow || hasNext != entry.m_hasNext || (hasNow && !ProgramsModel::isSame(current, entry.m_now))
+        || (hasNext && !ProgramsModel::isSame(next, entry.m_next));
+    entry.m_hasNow = hasNow;
+    entry.m_hasNext = hasNext;
+    entry.m_now = current;
+    entry.m_next = next;
+    return changed;
+}
+
+void NowNextModel::updateChannel(const ProgramsModel *programsModel)
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (int row = 0; row < m_entries.size(); ++row) {
+        if (m_entries.at(row).m_programsModel == programsModel && updateEntry(m_entries[row], now)) {
+            Q_EMIT dataChanged(index(row, 0), index(row, 0));
+        }
+    }
+    scheduleUpdate();
+}
+
+void NowNextModel::updateAll()
+{
+    TRACE_FUNCTION("model");
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (int row = 0; row < m_entries.size(); ++row) {
+        if (updateEntry(m_entries[row], now)) {
+            Q_EMIT dataChanged(index(row, 0), index(row, 0));
+        }
+    }
+    scheduleUpdate();
+}
+
+void NowNextModel::scheduleUpdate()
+{
+    // [s] first stop of a running program or start of a next one
+    qint64 boundary = std::numeric_limits<qint64>::max();
+    for (const Entry &entry : qAsConst(m_entries)) {
+        if (entry.m_hasNow) {
+            boundary = std::min(boundary, entry.m_now.m_stop);
+        } else if (entry.m_hasNext) {
+            boundary = std::min(boundary, entry.m_next.m_start);
+        }
+    }
+    if (boundary == std::numeric_limits<qint64>::max()) {
+        m_boundaryTimer.stop();
+        return;
+    }
+    const qint64 interval = boundary * 1000 - QDateTime::currentMSecsSinceEpoch();
+    m_boundaryTimer.start(static_cast<int>(std::max<qint64>(0, std::min<qint64>(interval, std::numeric_limits<int>::max()))));
+}
+
+void NowNextModel::onRowsInserted(const QModelIndex &parent, int first, int last)
+{
+    Q_UNUSED(parent)
+    beginInsertRows(QModelIndex(), first, last);
+    for (int row = first; row <= last; ++row) {
+        const Entry entry = createEntry(row);
+        connectEntry(entry);
+        m_entries.insert(row, entry);
+    }
+    endInsertRows();
+    scheduleUpdate();
+}
+
+void NowNextModel::onRowsRemoved(const QModelIndex &parent, int first, int last)
+{
+    Q_UNUSED(parent)
+    beginRemoveRows(QModelIndex(), first, last);
+    for (int row = first; row <= last; ++row) {
+        // the channel (and its programs) may be kept by the ChannelsModel
+        if (m_entries.at(row).m_programsModel) {
+            disconnect(m_entries.at(row).m_programsModel, nullptr, this, nullptr);
+        }
+    }
+    m_entries.remove(first, last - first + 1);
+    endRemoveRows();
+    scheduleUpdate();
+}
+
+void NowNextModel::onRowsMoved(const QModelIndex &parent, int first, int last, const QModelIndex &destination, int row)
+{
+    Q_UNUSED(parent)
+    Q_UNUSED(destination)
+    beginMoveRows(QModelIndex(), first, last, QModelIndex(), row);
+    const int count = last - first + 1;
+    const QVector<Entry> moved = m_entries.mid(first, count);
+    m_entries.remove(first, count);
+    const int to = row > last ? row - count : row;
+    for (int i = 0; i < count; ++i) {
+        m_entries.insert(to + i, moved.at(i));
+    }
+    endMoveRows();
+}
+
+void NowNextModel::reset()
+{
+    beginResetModel();
+    for (const Entry &entry : qAsConst(m_entries)) {
+        if (entry.m_programsModel) {
+            disconnect(entry.m_programsModel, nullptr, this, nullptr);
+        }
+    }
+    m_entries.clear();
+
+    const int count = m_channelsModel ? m_channelsModel->rowCount(QModelIndex()) : 0;
+    m_entries.reserve(count);
+    for (int row = 0; row < count; ++row) {
+        const Entry entry = createEntry(row);
+        connectEntry(entry);
+        m_entries.append(entry);
+    }
+    endResetModel();
+    scheduleUpdate();
+}
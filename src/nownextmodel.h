@@ -0,0 +1,77 @@
+#pragma once
+
+#include <QAbstractListModel>
+
+#include "programrowdata.h"
+
+#include <QPointer>
+#include <QTimer>
+#include <QVector>
+
+class ChannelsModel;
+class ProgramsModel;
+
+// running and next program of every channel of a ChannelsModel (same rows)
+// a single timer fires at the next program boundary of all channels, only the channels whose program changed are signaled
+class NowNextModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+    Q_PROPERTY(ChannelsModel *channelsModel READ channelsModel WRITE setChannelsModel NOTIFY channelsModelChanged)
+
+public:
+    enum Role {
+        ChannelRole = Qt::DisplayRole, // Channel *
+        NowAvailableRole = Qt::UserRole + 1, // bool, false if nothing is running
+        NowIdRole,
+        NowTitleRole,
+        NowStartRole, // [ms] since epoch
+        NowStopRole,
+        NowStartTextRole, // localized short time
+        NowStopTextRole,
+        NextAvailableRole,
+        NextTitleRole,
+        NextStartRole,
+        NextStartTextRole,
+    };
+    Q_ENUM(Role)
+
+    explicit NowNextModel(QObject *parent = nullptr);
+    ~NowNextModel() override = default;
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+    int rowCount(const QModelIndex &parent) const override;
+
+    ChannelsModel *channelsModel() const;
+    void setChannelsModel(ChannelsModel *channelsModel);
+
+Q_SIGNALS:
+    void channelsModelChanged();
+
+private:
+    struct Entry {
+        QPointer<ProgramsModel> m_programsModel;
+        bool m_hasNow = false;
+        bool m_hasNext = false;
+        ProgramRowData m_now;
+        ProgramRowData m_next;
+    };
+
+    Entry createEntry(int row) const;
+    void connectEntry(const Entry &entry);
+    bool updateEntry(Entry &entry, qint64 now) const; // true if changed
+    void updateChannel(const ProgramsModel *programsModel);
+    void updateAll();
+    void scheduleUpdate(); // at the next boundary of all channels
+
+    // rows follow the ChannelsModel
+    void onRowsInserted(const QModelIndex &parent, int first, int last);
+    void onRowsRemoved(const QModelIndex &parent, int first, int last);
+    void onRowsMoved(const QModelIndex &parent, int first, int last, const QModelIndex &destination, int row);
+    void reset();
+
+    QPointer<ChannelsModel> m_channelsModel;
+    QVector<Entry> m_entries;
+    QTimer m_boundaryTimer;
+};
@@ -0,0 +1,129 @@
+#include "parserpool.h"
+
+#include "tracer.h"
+
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QThread>
+
+#include <algorithm>
+#include <atomic>
+
+namespace
+{
+// jobs (i.e. whole replies) which may wait for a thread before the producers are paused
+const int MAX_WAITING_JOBS_PER_THREAD = 2;
+}
+
+struct ParserPool::Job {
+    QString m_name;
+    QObject *m_context = nullptr; // only valid if not cancelled
+    std::function<void()> m_parse;
+    std::function<void()> m_done;
+    QMetaObject::Connection m_contextConnection;
+    std::atomic<bool> m_cancelled{false};
+    QElapsedTimer m_timer;
+    qint64 m_waitTime = 0;
+    qint64 m_parseTime = 0;
+};
+
+ParserPool::ParserPool()
+    : QObject(nullptr)
+{
+    // keep one core for the GUI
+    m_threadPool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+}
+
+ParserPool::~ParserPool()
+{
+    cancelAll();
+    m_threadPool.waitForDone();
+}
+
+void ParserPool::submit(QObject *context, const QString &name, const std::function<void()> &parse, const std::function<void()> &done)
+{
+    std::shared_ptr<Job> job = std::make_shared<Job>();
+    job->m_name = name;
+    job->m_context = context;
+    job->m_parse = parse;
+    job->m_done = done;
+    job->m_contextConnection = connect(context, &QObject::destroyed, this, [job]() {
+        job->m_cancelled = true;
+    });
+    job->m_timer.start();
+
+    m_waiting.enqueue(job);
+    startJobs();
+    m_saturated = m_saturated || isSaturated();
+}
+
+void ParserPool::cancelAll()
+{
+    for (const std::shared_ptr<Job> &job : qAsConst(m_waiting)) {
+        disconnect(job->m_contextConnection);
+    }
+    m_waiting.clear();
+
+    // results of running jobs are discarded
+    for (const std::shared_ptr<Job> &job : qAsConst(m_running)) {
+        job->m_cancelled = true;
+    }
+}
+
+int ParserPool::pendingCount() const
+{
+    return m_waiting.size() + m_running.size();
+}
+
+bool ParserPool::isSaturated() const
+{
+    return m_waiting.size() >= m_threadPool.maxThreadCount() * MAX_WAITING_JOBS_PER_THREAD;
+}
+
+void ParserPool::startJobs()
+{
+    // only as many jobs as threads are started, the others wait here (see isSaturated())
+    while (!m_waiting.isEmpty() && m_running.size() < m_threadPool.maxThreadCount()) {
+        std::shared_ptr<Job> job = m_waiting.dequeue();
+        if (job->m_cancelled) {
+            disconnect(job->m_contextConnection);
+            continue;
+        }
+        job->m_waitTime = job->m_timer.nsecsElapsed() / 1000;
+        m_running.append(job);
+
+        m_threadPool.start([this, job]() {
+            if (!job->m_cancelled) {
+                TraceSpan span("parse", "ParserPool job");
+                span.setDetail(job->m_name);
+                QElapsedTimer timer;
+                timer.start();
+                job->m_parse();
+                job->m_parseTime = timer.nsecsElapsed() / 1000;
+            }
+            QMetaObject::invokeMethod(
+                this,
+                [this, job]() {
+                    finishJob(job);
+                },
+                Qt::QueuedConnection);
+        });
+    }
+}
+
+void ParserPool::finishJob(const std::shared_ptr<Job> &job)
+{
+    m_running.erase(std::remove(m_running.begin(), m_running.end(), job), m_running.end());
+    disconnect(job->m_contextConnection);
+
+    if (!job->m_cancelled) {
+        Q_EMIT jobFinished(job->m_name, job->m_waitTime, job->m_parseTime, job->m_context);
+        job->m_done();
+    }
+
+    startJobs();
+    if (m_saturated && !isSaturated()) {
+        m_saturated = false;
+        Q_EMIT available();
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QObject>
+
+#include <QQueue>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+
+#include <functional>
+#include <memory>
+
+// runs the parsing of fetched data on worker threads (off the GUI thread)
+class ParserPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    static ParserPool &instance()
+    {
+        static ParserPool _instance;
+        return _instance;
+    }
+
+    // runs parse() on a worker thread and afterwards done() with the result on the thread of the pool (GUI thread)
+    // the job is cancelled if the context is destroyed before it is done (e.g. delete the network reply which is parsed)
+    template<class T>
+    void submit(QObject *context, const QString &name, const std::function<T()> &parse, const std::function<void(T &)> &done)
+    {
+        std::shared_ptr<T> result = std::make_shared<T>();
+        submit(
+            context,
+            name,
+            [parse, result]() {
+                *result = parse();
+            },
+            [done, result]() {
+                done(*result);
+            });
+    }
+    void submit(QObject *context, const QString &name, const std::function<void()> &parse, const std::function<void()> &done);
+
+    void cancelAll();
+    int pendingCount() const; // waiting + running
+    // backpressure: producers which can wait (e.g. request the next page later) do not submit while the queue is full
+    // submit() still accepts jobs then, available() is emitted when there is space again
+    bool isSaturated() const;
+
+Q_SIGNALS:
+    void available();
+    void jobFinished(const QString &name, qint64 waitTime, qint64 parseTime, QObject *context); // [us], context of submit()
+
+private:
+    ParserPool();
+    ~ParserPool();
+
+    struct Job;
+    void startJobs();
+    void finishJob(const std::shared_ptr<Job> &job);
+
+    QThreadPool m_threadPool;
+    QQueue<std::shared_ptr<Job>> m_waiting; // not more jobs than threads are handed to the thread pool (cheap cancellation)
+    QVector<std::shared_ptr<Job>> m_running;
+    bool m_saturated = false; // available() is pending
+};
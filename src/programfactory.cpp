@@ -1,47 +1,114 @@
 #include "programfactory.h"
 
 #include "database.h"
+#include "programdata.h"
 #include "fetcher.h"
-#include "program.h"
+#include "tracer.h"
 
+#include <QDateTime>
 #include <QDebug>
+#include <QLocale>
 
 ProgramFactory::ProgramFactory()
     : QObject(nullptr)
 {
-    m_programs = Database::instance().programs();
+    // the days which are fetched (until changed by the view)
+    const QDateTime today(QDate::currentDate(), QTime(0, 0));
+    m_from = today.addDays(-1).toSecsSinceEpoch();
+    m_to = today.addDays(2).toSecsSinceEpoch();
+
+    // programs are loaded per channel when they are shown (not the whole table while starting up)
+    m_loadTimer.setSingleShot(true);
+    m_loadTimer.setInterval(0);
+    connect(&m_loadTimer, &QTimer::timeout, this, &ProgramFactory::loadNext);
 }
 
-size_t ProgramFactory::count(const ChannelId &channelId) const
+QVector<ProgramRowData> ProgramFactory::programs(const ChannelId &channelId) const
 {
-    // try to load if not avaible
-    if (!m_programs.contains(channelId)) {
-        load(channelId);
+    // load if not available (the model is updated when it is loaded)
+    auto it = m_programs.constFind(channelId);
+    if (it == m_programs.constEnd()) {
+        requestLoad(channelId);
+        return QVector<ProgramRowData>();
     }
-    // check if requested data exists
-    if (!m_programs.contains(channelId)) {
-        return 0;
+    return it.value();
+}
+
+void ProgramFactory::load(const ChannelId &channelId) const
+{
+    TRACE_FUNCTION("model");
+    const QVector<ProgramData> programs = Database::instance().programs(channelId, m_from, m_to);
+    const QLocale locale;
+
+    QVector<ProgramRowData> rows;
+    rows.reserve(programs.size());
+    for (const ProgramData &data : programs) {
+        ProgramRowData row;
+        row.m_id = data.m_id;
+        row.m_url = data.m_url;
+        row.m_start = data.m_startTime.toSecsSinceEpoch();
+        row.m_stop = data.m_stopTime.toSecsSinceEpoch();
+        row.m_title = data.m_title;
+        row.m_subtitle = data.m_subtitle;
+        row.m_description = data.m_description;
+        row.m_descriptionFetched = data.m_descriptionFetched;
+        row.m_category = data.m_category;
+
+        // avoid gaps/overlapping in the program (causes not aligned times in table)
+        if (!rows.isEmpty() && rows.last().m_stop != row.m_start) {
+            row.m_start = rows.last().m_stop;
+            row.m_startText = rows.last().m_stopText;
+        } else {
+            row.m_startText = locale.toString(data.m_startTime.time(), QLocale::ShortFormat);
+        }
+        row.m_stopText = locale.toString(data.m_stopTime.time(), QLocale::ShortFormat);
+        rows.append(row);
     }
-    return m_programs[channelId].size();
+    m_programs[channelId] = rows;
+    m_outdated.remove(channelId);
 }
 
-Program *ProgramFactory::create(const ChannelId &channelId, int index) const
+void ProgramFactory::setRange(qint64 from, qint64 to)
 {
-    // try to load if not avaible
-    if (!m_programs.contains(channelId)) {
-        load(channelId);
+    if (from == m_from && to == m_to) {
+        return;
     }
-    // check if requested data exists
-    if (!m_programs.contains(channelId) || m_programs[channelId].size() <= index) {
-        return nullptr;
+    m_from = from;
+    m_to = to;
+
+    // the models keep the old programs until the new ones are loaded (then only the difference is applied)
+    for (auto it = m_programs.constBegin(); it != m_programs.constEnd(); ++it) {
+        m_outdated.insert(it.key());
+        requestLoad(it.key());
     }
-    return new Program(m_programs[channelId].at(index));
 }
 
-void ProgramFactory::load(const ChannelId &channelId) const
+void ProgramFactory::requestLoad(const ChannelId &channelId) const
 {
-    if (m_programs.contains(channelId)) {
-        m_programs.remove(channelId);
+    if (!m_pendingLoads.contains(channelId)) {
+        m_pendingLoads.append(channelId);
     }
-    m_programs[channelId] = Database::instance().programs(channelId);
+    if (!m_loadTimer.isActive()) {
+        m_loadTimer.start();
+    }
+}
+
+void ProgramFactory::loadNext()
+{
+    if (m_pendingLoads.isEmpty()) {
+        return;
+    }
+    const ChannelId channelId = m_pendingLoads.takeFirst();
+    if (!m_programs.contains(channelId) || m_outdated.contains(channelId)) {
+        load(channelId);
+        m_loaded.dispatch(channelId);
+    }
+    if (!m_pendingLoads.isEmpty()) {
+        m_loadTimer.start();
+    }
+}
+
+EventDispatcher<ChannelId> &ProgramFactory::loaded()
+{
+    return m_loaded;
 }
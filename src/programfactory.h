@@ -2,14 +2,15 @@
 
 #include <QObject>
 
-#include "programdata.h"
+#include "eventhub.h"
+#include "programrowdata.h"
 #include "types.h"
 
 #include <QMap>
+#include <QSet>
+#include <QTimer>
 #include <QVector>
 
-class Program;
-
 class ProgramFactory : public QObject
 {
     Q_OBJECT
@@ -18,10 +19,24 @@ public:
     ProgramFactory();
     ~ProgramFactory() = default;
 
-    size_t count(const ChannelId &channelId) const;
-    Program *create(const ChannelId &channelId, int index) const;
-    void load(const ChannelId &channelId) const;
+    // empty until loaded (loads asynchronously)
+    QVector<ProgramRowData> programs(const ChannelId &channelId) const;
+    void load(const ChannelId &channelId) const; // blocking
+
+    // only programs running in [from, to) are kept in memory, changing it reloads the loaded channels (asynchronously)
+    void setRange(qint64 from, qint64 to); // [s] since epoch
+
+    EventDispatcher<ChannelId> &loaded(); // asynchronous load finished
 
 private:
-    mutable QMap<ChannelId, QVector<ProgramData>> m_programs;
+    void requestLoad(const ChannelId &channelId) const;
+    void loadNext();
+
+    mutable QMap<ChannelId, QVector<ProgramRowData>> m_programs;
+    mutable QSet<ChannelId> m_outdated; // loaded for the previous range (kept until reloaded)
+    qint64 m_from; // [s]
+    qint64 m_to;
+    mutable QVector<ChannelId> m_pendingLoads; // one channel per event loop iteration (keeps the window responsive)
+    mutable QTimer m_loadTimer;
+    EventDispatcher<ChannelId> m_loaded;
 };
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "types.h"
+
+#include <QString>
+
+// program as shown by the ProgramsModel: plain data, times as seconds since epoch, display strings precomputed
+struct ProgramRowData {
+    ProgramId m_id;
+    QString m_url;
+    qint64 m_start = 0; // [s] since epoch, aligned to the stop of the previous program
+    qint64 m_stop = 0; // [s] since epoch
+    QString m_title;
+    QString m_subtitle;
+    QString m_description;
+    bool m_descriptionFetched = false;
+    QString m_category;
+    QString m_startText; // localized short time
+    QString m_stopText;
+};
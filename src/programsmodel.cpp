@@ -2,74 +2,136 @@
 
 #include "channel.h"
 #include "database.h"
-#include "fetcher.h"
-#include "program.h"
+#include "eventhub.h"
 #include "programfactory.h"
+#include "tracer.h"
 #include "types.h"
 
 #include <QDebug>
 
+#include <algorithm>
+
 ProgramsModel::ProgramsModel(Channel *channel, ProgramFactory &programFactory)
-    : QAbstractListModel(channel)
+    : SortedListModel(channel)
     , m_channel(channel)
+    , m_programs(programFactory.programs(ChannelId(channel->id())))
     , m_programFactory(programFactory)
 {
-    connect(&Fetcher::instance(), &Fetcher::channelUpdated, this, [this](const ChannelId &id) {
-        if (m_channel->id() == id.value()) {
-            beginResetModel();
-            m_programFactory.load(ChannelId(m_channel->id()));
-            for (auto &program : m_programs) {
-                delete program;
-            }
-            m_programs.clear();
-            endResetModel();
-        }
+    const ChannelId channelId(channel->id());
+    EventHub::instance().channelUpdated().subscribe(channelId, this, [this, channelId]() {
+        m_programFactory.load(channelId);
+        update(m_programFactory.programs(channelId));
+    });
+
+    m_programFactory.loaded().subscribe(channelId, this, [this, channelId]() {
+        update(m_programFactory.programs(channelId));
+    });
+}
+
+void ProgramsModel::update(const QVector<ProgramRowData> &programs)
+{
+    TRACE_FUNCTION("model");
+    // the ID is the key (another program at the same start replaces the current one)
+    mergeRows(
+        m_programs,
+        programs,
+        [](const ProgramRowData &l, const ProgramRowData &r) {
+            return l.m_start < r.m_start;
+        },
+        [](const ProgramRowData &l, const ProgramRowData &r) {
+            return l.m_id == r.m_id;
+        },
+        &ProgramsModel::isSame);
+
+    // same content: share the data with the ProgramFactory again
+    m_programs = programs;
+}
+
+QVector<ProgramRowData>::const_iterator ProgramsModel::firstNotEnded(const QVector<ProgramRowData> &programs, qint64 time)
+{
+    // sorted by start and without overlaps, i.e. sorted by stop as well
+    return std::partition_point(programs.begin(), programs.end(), [time](const ProgramRowData &program) {
+        return program.m_stop <= time;
     });
 }
 
-ProgramsModel::~ProgramsModel()
+bool ProgramsModel::isSame(const ProgramRowData &l, const ProgramRowData &r)
 {
-    qDeleteAll(m_programs);
+    return l.m_id == r.m_id && l.m_url == r.m_url && l.m_start == r.m_start && l.m_stop == r.m_stop && l.m_title == r.m_title && l.m_subtitle == r.m_subtitle
+        && l.m_description == r.m_description && l.m_descriptionFetched == r.m_descriptionFetched && l.m_category == r.m_category;
 }
 
 QVariant ProgramsModel::data(const QModelIndex &index, int role) const
 {
-    if (role != 0) {
+    if (!index.isValid() || index.row() >= m_programs.size()) {
         return QVariant();
     }
-    if (m_programs[index.row()] == nullptr) {
-        loadProgram(index.row());
+    if (role == ChannelIdRole) {
+        return m_channel->id();
+    }
+    return programData(m_programs.at(index.row()), role);
+}
+
+QVariant ProgramsModel::programData(const ProgramRowData &program, int role)
+{
+    switch (role) {
+    case IdRole:
+        return program.m_id.value();
+    case UrlRole:
+        return program.m_url;
+    case StartRole:
+        return program.m_start * 1000;
+    case StopRole:
+        return program.m_stop * 1000;
+    case TitleRole:
+        return program.m_title;
+    case SubtitleRole:
+        return program.m_subtitle;
+    case DescriptionRole:
+        return program.m_description;
+    case DescriptionFetchedRole:
+        return program.m_descriptionFetched;
+    case CategoryRole:
+        return program.m_category;
+    case StartTextRole:
+        return program.m_startText;
+    case StopTextRole:
+        return program.m_stopText;
+    default:
+        return QVariant();
     }
-    return QVariant::fromValue(m_programs[index.row()]);
 }
 
 QHash<int, QByteArray> ProgramsModel::roleNames() const
 {
     QHash<int, QByteArray> roleNames;
-    roleNames[0] = "program";
+    roleNames[IdRole] = "id";
+    roleNames[ChannelIdRole] = "channelId";
+    roleNames[UrlRole] = "url";
+    roleNames[StartRole] = "start";
+    roleNames[StopRole] = "stop";
+    roleNames[TitleRole] = "title";
+    roleNames[SubtitleRole] = "subtitle";
+    roleNames[DescriptionRole] = "description";
+    roleNames[DescriptionFetchedRole] = "descriptionFetched";
+    roleNames[CategoryRole] = "category";
+    roleNames[StartTextRole] = "startText";
+    roleNames[StopTextRole] = "stopText";
     return roleNames;
 }
 
 int ProgramsModel::rowCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent)
-    return m_programFactory.count(ChannelId(m_channel->id()));
+    return m_programs.size();
 }
 
-void ProgramsModel::loadProgram(int index) const
+Channel *ProgramsModel::channel() const
 {
-    Program *program = m_programFactory.create(ChannelId(m_channel->id()), index);
-
-    if (program) {
-        // avoid gaps/overlapping in the program (causes not aligned times in table)
-        if (m_programs.contains(index - 1) && m_programs[index - 1]->stop() != program->start()) {
-            program->setStart(m_programs[index - 1]->stop());
-        }
-        m_programs[index] = program;
-    }
+    return m_channel;
 }
 
-Channel *ProgramsModel::channel() const
+const QVector<ProgramRowData> &ProgramsModel::programs() const
 {
-    return m_channel;
+    return m_programs;
 }
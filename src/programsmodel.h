@@ -1,33 +1,58 @@
 #pragma once
 
-#include <QAbstractListModel>
+#include "programrowdata.h"
+#include "sortedlistmodel.h"
 
 #include <QHash>
 #include <QObject>
+#include <QVector>
 
 class Channel;
-class Program;
 class ProgramFactory;
 
-class ProgramsModel : public QAbstractListModel
+class ProgramsModel : public SortedListModel
 {
     Q_OBJECT
 
     Q_PROPERTY(Channel *channel READ channel CONSTANT)
 
 public:
+    enum Role {
+        IdRole = Qt::UserRole + 1,
+        ChannelIdRole,
+        UrlRole,
+        StartRole, // [ms] since epoch (can be compared with a JavaScript Date)
+        StopRole, // [ms] since epoch
+        TitleRole,
+        SubtitleRole,
+        DescriptionRole,
+        DescriptionFetchedRole,
+        CategoryRole,
+        StartTextRole, // localized short time
+        StopTextRole,
+    };
+    Q_ENUM(Role)
+
     explicit ProgramsModel(Channel *channel, ProgramFactory &programFactory);
-    ~ProgramsModel() override;
+    ~ProgramsModel() override = default;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
     QHash<int, QByteArray> roleNames() const override;
     int rowCount(const QModelIndex &parent) const override;
 
     Channel *channel() const;
+    const QVector<ProgramRowData> &programs() const; // sorted by start
+    // first of programs which stops after time [s] (binary search)
+    static QVector<ProgramRowData>::const_iterator firstNotEnded(const QVector<ProgramRowData> &programs, qint64 time);
+
+    static QVariant programData(const ProgramRowData &program, int role); // all roles except ChannelIdRole
+    static bool isSame(const ProgramRowData &l, const ProgramRowData &r);
 
 private:
-    void loadProgram(int index) const;
+    friend class ModelsTest;
+
+    void update(const QVector<ProgramRowData> &programs); // applies the changes only
 
     Channel *m_channel;
-    mutable QHash<int, Program *> m_programs;
+    QVector<ProgramRowData> m_programs; // shared with the ProgramFactory
     ProgramFactory &m_programFactory;
 };
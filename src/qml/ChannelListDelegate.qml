@@ -37,7 +37,7 @@ Kirigami.SwipeListItem {
         }
 
         Kirigami.Icon {
-            source: model.channel.refreshing ? "view-refresh" : model.channel.image === "" ? "rss" : Fetcher.image(model.channel.image)
+            source: model.channel.refreshing ? "view-refresh" : model.channel.image === "" ? "rss" : "image://logo/" + encodeURIComponent(model.channel.image)
         }
 
         Controls.Label {
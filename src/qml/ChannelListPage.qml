@@ -21,6 +21,17 @@ Kirigami.ScrollablePage {
 
     }
 
+    // type-ahead search (not needed for the favorites)
+    header: Controls.ToolBar {
+        visible: !root.onlyFavorites
+
+        Kirigami.SearchField {
+            anchors.fill: parent
+            onTextChanged: proxyModel.search = text
+        }
+
+    }
+
     Kirigami.PlaceholderMessage {
         visible: channelList.count === 0
         width: Kirigami.Units.gridUnit * 20
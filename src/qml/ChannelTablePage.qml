@@ -10,12 +10,69 @@ Kirigami.Page {
 
     property int windowHeight: 0
     property real currentTimestamp: 0
+    // the days [firstDay, firstDay + shownDays) can be scrolled, the window slides when an end is reached
+    property var firstDay: dayStart(new Date(), -1)
+    readonly property int shownDays: 3
 
     function updateTime() {
         var now = new Date();
         currentTimestamp = now.getTime();
     }
 
+    // 00:00h of the day days after date
+    function dayStart(date, days) {
+        return new Date(date.getFullYear(), date.getMonth(), date.getDate() + days);
+    }
+
+    // moves the shown days by one if the viewport is close to an end (memory does not grow however far it is scrolled)
+    function slideWindow() {
+        if (content.height <= 0 || content.contentHeight <= content.height)
+            return ;
+
+        const margin = content.height;
+        var days = 0;
+        if (content.contentY + content.height > content.contentHeight - margin)
+            days = 1;
+        else if (content.contentY < margin)
+            days = -1;
+        if (days === 0)
+            return ;
+
+        const oldStart = epgGrid.start.getTime();
+        firstDay = dayStart(firstDay, days);
+        // keep the visible programs in place
+        content.contentY -= (epgGrid.start.getTime() - oldStart) / 60000 * channelTable.pxPerMin;
+        // the programs of the next day are loaded from the database already (see programsStart/programsStop), fetch it as well
+        Fetcher.fetchFavoritesDay(days > 0 ? dayStart(firstDay, shownDays) : dayStart(firstDay, -1));
+    }
+
+    // fetch the descriptions of the visible programs (and the ones close to them) in the background
+    function prefetchDescriptions() {
+        const start = epgGrid.start.getTime();
+        const topMin = content.contentY / channelTable.pxPerMin;
+        const heightMin = content.height / channelTable.pxPerMin;
+        const marginMin = 2 * 60;
+        const from = new Date(start + (topMin - marginMin) * 60000);
+        const to = new Date(start + (topMin + heightMin + marginMin) * 60000);
+        Fetcher.prefetchDescriptions(from, to);
+    }
+
+    function showProgram(program) {
+        if (!program.descriptionFetched)
+            Fetcher.fetchProgramDescription(program.channelId, program.id, program.url);
+
+        var categoryText = "";
+        if (program.category !== "")
+            categoryText = "<br><i>" + program.category + "</i>";
+
+        var descriptionText = "";
+        if (program.descriptionFetched && program.description)
+            descriptionText = "<br><br>" + program.description;
+
+        overlaySheet.text = "<b>" + program.startText + "-" + program.stopText + " " + program.title + "</b>" + categoryText + descriptionText;
+        overlaySheet.programId = program.id;
+    }
+
     title: i18n("Favorites")
     padding: 0
     Component.onCompleted: {
@@ -30,8 +87,36 @@ Kirigami.Page {
         onTriggered: updateTime()
     }
 
+    // do not prefetch for every scroll step
+    Timer {
+        id: prefetchTimer
+
+        interval: 300
+        onTriggered: prefetchDescriptions()
+    }
+
+    Connections {
+        function onPositionChanged() {
+            prefetchTimer.restart();
+        }
+
+        target: channelTable.Controls.ScrollBar.vertical
+    }
+
+    Kirigami.PlaceholderMessage {
+        visible: !channelsModel.loaded
+        width: Kirigami.Units.gridUnit * 20
+        anchors.centerIn: parent
+        text: i18n("Loading favorites...")
+
+        Controls.BusyIndicator {
+            Layout.alignment: Qt.AlignHCenter | Qt.AlignVCenter
+        }
+
+    }
+
     Kirigami.PlaceholderMessage {
-        visible: contentRepeater.count === 0
+        visible: channelsModel.loaded && headerRepeater.count === 0
         width: Kirigami.Units.gridUnit * 20
         icon.name: "rss"
         anchors.centerIn: parent
@@ -41,8 +126,8 @@ Kirigami.Page {
     Row {
         id: header
 
-        x: -channelTable.Controls.ScrollBar.horizontal.position * channelTable.contentWidth
-        visible: contentRepeater.count !== 0
+        x: -content.contentX
+        visible: headerRepeater.count !== 0
         z: 100 // TODO: remove workaround for mobile (channelTable "anchors.top: header.bottom" not respected)
 
         Repeater {
@@ -51,7 +136,7 @@ Kirigami.Page {
             model: channelsModel
 
             delegate: Column {
-                width: 200
+                width: channelTable.columnWidth
 
                 Rectangle {
                     color: Kirigami.Theme.backgroundColor
@@ -59,10 +144,30 @@ Kirigami.Page {
                     height: 30
                     border.color: Kirigami.Theme.textColor
 
+                    Image {
+                        id: logo
+
+                        anchors.left: parent.left
+                        anchors.leftMargin: 3
+                        anchors.verticalCenter: parent.verticalCenter
+                        width: 48
+                        height: 24
+                        // rasterized at exactly this size (off the GUI thread)
+                        sourceSize: Qt.size(width, height)
+                        fillMode: Image.PreserveAspectFit
+                        asynchronous: true
+                        source: modelData.image !== "" ? "image://logo/" + encodeURIComponent(modelData.image) : ""
+                    }
+
                     Text {
                         text: modelData.name
                         color: Kirigami.Theme.textColor
-                        anchors.centerIn: parent
+                        anchors.left: logo.right
+                        anchors.right: parent.right
+                        anchors.margins: 3
+                        anchors.verticalCenter: parent.verticalCenter
+                        horizontalAlignment: Text.AlignHCenter
+                        elide: Text.ElideRight
                     }
 
                 }
@@ -77,80 +182,71 @@ Kirigami.Page {
         id: channelTable
 
         readonly property int pxPerMin: 5
-        readonly property var date: new Date()
+        readonly property int columnWidth: 200
 
-        visible: contentRepeater.count !== 0
+        visible: headerRepeater.count !== 0
         width: parent.width
         height: parent.height - header.height
         anchors.top: header.bottom
-        contentHeight: 24 * 60 * pxPerMin
         Component.onCompleted: {
-            // scroll to current time
-            var today = new Date();
-            today.setHours(0);
-            today.setMinutes(0);
-            today.setSeconds(0);
-            const now = new Date();
-            // offset [s] to 00:00h
-            const offsetS = (now.getTime() - today.getTime()) / 1000;
-            // center in window (vertically)
-            Controls.ScrollBar.vertical.position = offsetS / (24 * 60 * 60) - (windowHeight / 2) / channelTable.contentHeight;
+            // scroll to current time, centered in window (vertically)
+            const offsetMin = (new Date().getTime() - epgGrid.start.getTime()) / 60000;
+            content.contentY = Math.max(0, offsetMin * pxPerMin - windowHeight / 2);
+            prefetchTimer.restart();
         }
 
-        Row {
+        Flickable {
             id: content
 
-            Repeater {
-                id: contentRepeater
-
-                model: channelsModel
-
-                delegate: Column {
-                    id: column
-
-                    property int idx: index
-
-                    width: 200
+            contentWidth: epgGrid.contentWidth
+            contentHeight: epgGrid.contentHeight
+            clip: true
+            // not while flicking (the position would jump), it is continued from the moved window
+            onContentYChanged: {
+                if (!moving)
+                    root.slideWindow();
 
-                    // show info if program is not available
-                    Rectangle {
-                        width: parent.width
-                        height: channelTable.contentHeight
-                        visible: programRepeater.count === 0
-                        color: Kirigami.Theme.negativeBackgroundColor
-                        border.color: Kirigami.Theme.textColor
-
-                        Text {
-                            anchors.centerIn: parent
-                            text: i18n("not available")
-                            wrapMode: Text.Wrap
-                            color: Kirigami.Theme.textColor
-                        }
-
-                    }
-
-                    Repeater {
-                        id: programRepeater
-
-                        model: ProgramsProxyModel {
-                            id: proxyProgramModel
+            }
+            onMovementEnded: root.slideWindow()
+
+            // only the programs in the viewport are drawn (positioned by the EpgGridModel)
+            EpgGrid {
+                id: grid
+
+                width: content.contentWidth
+                height: content.contentHeight
+                currentTimestamp: root.currentTimestamp
+                font: Kirigami.Theme.defaultFont
+                textColor: Kirigami.Theme.textColor
+                disabledTextColor: Kirigami.Theme.disabledTextColor
+                alternateBackgroundColor: Kirigami.Theme.alternateBackgroundColor
+                unavailableColor: Kirigami.Theme.negativeBackgroundColor
+                highlightColor: Kirigami.Theme.focusColor
+                borderColor: "transparent"
+                unavailableText: i18n("not available")
+                onClicked: {
+                    showProgram(epgGrid.get(row));
+                    overlaySheet.open();
+                }
 
-                            start: new Date(channelTable.date.getFullYear(), channelTable.date.getMonth(), channelTable.date.getDate()) // today 00:00h
-                            stop: new Date(channelTable.date.getFullYear(), channelTable.date.getMonth(), channelTable.date.getDate(), 23, 59, 0) // today 23:59h
-                            sourceModel: modelData.programsModel
-                        }
+                model: EpgGridModel {
+                    id: epgGrid
+
+                    channelsModel: channelsModel
+                    start: root.firstDay
+                    stop: root.dayStart(root.firstDay, root.shownDays)
+                    pxPerMin: channelTable.pxPerMin
+                    columnWidth: channelTable.columnWidth
+                    viewport: Qt.rect(content.contentX, content.contentY, content.width, content.height)
+                    // update overlay if it is open (e.g. the description was fetched)
+                    onDataChanged: {
+                        if (overlaySheet.sheetOpen) {
+                            const row = find(overlaySheet.programId);
+                            if (row >= 0)
+                                showProgram(get(row));
 
-                        delegate: ChannelTableDelegate {
-                            channelIdx: column.idx
-                            overlay: overlaySheet
-                            pxPerMin: channelTable.pxPerMin
-                            startTime: proxyProgramModel.start
-                            stopTime: proxyProgramModel.stop
-                            currentTimestamp: root.currentTimestamp
                         }
-
                     }
-
                 }
 
             }
@@ -163,6 +259,9 @@ Kirigami.Page {
         id: channelsModel
 
         onlyFavorites: true
+        // one more day at both ends: loaded before it is scrolled into view, evicted when it is far away
+        programsStart: root.dayStart(root.firstDay, -1)
+        programsStop: root.dayStart(root.firstDay, root.shownDays + 1)
     }
 
     Kirigami.OverlaySheet {
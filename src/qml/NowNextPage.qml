@@ -0,0 +1,116 @@
+import QtQuick 2.14
+import QtQuick.Controls 2.14 as Controls
+import QtQuick.Layouts 1.14
+import org.kde.TellySkout 1.0
+import org.kde.kirigami 2.19 as Kirigami
+
+Kirigami.ScrollablePage {
+    id: root
+
+    // today and tomorrow are loaded (the next program of a late one is tomorrow), moved at midnight
+    property var today: dayStart(new Date(), 0)
+
+    // 00:00h of the day days after date
+    function dayStart(date, days) {
+        return new Date(date.getFullYear(), date.getMonth(), date.getDate() + days);
+    }
+
+    title: i18n("What's On Now")
+    Component.onCompleted: Fetcher.fetchFavorites()
+
+    // restarted with the new interval when today changes
+    Timer {
+        interval: root.dayStart(root.today, 1).getTime() - Date.now() + 1000
+        repeat: true
+        running: true
+        onTriggered: {
+            root.today = root.dayStart(new Date(), 0);
+            Fetcher.fetchFavoritesDay(root.dayStart(root.today, 1));
+        }
+    }
+
+    Kirigami.PlaceholderMessage {
+        visible: !channelsModel.loaded
+        width: Kirigami.Units.gridUnit * 20
+        anchors.centerIn: parent
+        text: i18n("Loading favorites...")
+
+        Controls.BusyIndicator {
+            Layout.alignment: Qt.AlignHCenter | Qt.AlignVCenter
+        }
+
+    }
+
+    Kirigami.PlaceholderMessage {
+        visible: channelsModel.loaded && nowNextList.count === 0
+        width: Kirigami.Units.gridUnit * 20
+        icon.name: "rss"
+        anchors.centerIn: parent
+        text: i18n("Please select favorites")
+    }
+
+    ListView {
+        id: nowNextList
+
+        anchors.fill: parent
+        currentIndex: -1 // do not select first list item
+
+        // updated at program boundaries only (by the model)
+        model: NowNextModel {
+            channelsModel: channelsModel
+        }
+
+        delegate: Kirigami.AbstractListItem {
+            contentItem: RowLayout {
+                Image {
+                    Layout.preferredWidth: 48
+                    Layout.preferredHeight: 24
+                    // rasterized at exactly this size (off the GUI thread)
+                    sourceSize: Qt.size(48, 24)
+                    fillMode: Image.PreserveAspectFit
+                    asynchronous: true
+                    source: model.channel.image !== "" ? "image://logo/" + encodeURIComponent(model.channel.image) : ""
+                }
+
+                ColumnLayout {
+                    Layout.fillWidth: true
+                    spacing: 0
+
+                    Controls.Label {
+                        Layout.fillWidth: true
+                        text: model.channel.name
+                        font.bold: true
+                        elide: Text.ElideRight
+                    }
+
+                    Controls.Label {
+                        Layout.fillWidth: true
+                        text: model.nowAvailable ? model.nowStartText + "-" + model.nowStopText + " " + model.nowTitle : i18n("not available")
+                        elide: Text.ElideRight
+                    }
+
+                    Controls.Label {
+                        Layout.fillWidth: true
+                        visible: model.nextAvailable
+                        text: i18n("Next: %1 %2", model.nextStartText, model.nextTitle)
+                        color: Kirigami.Theme.disabledTextColor
+                        elide: Text.ElideRight
+                    }
+
+                }
+
+            }
+
+        }
+
+    }
+
+    ChannelsModel {
+        id: channelsModel
+
+        onlyFavorites: true
+        programsStart: root.today
+        programsStop: root.dayStart(root.today, 2)
+    }
+
+}
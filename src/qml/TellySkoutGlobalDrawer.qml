@@ -19,6 +19,15 @@ Kirigami.GlobalDrawer {
                 });
             }
         },
+        Kirigami.Action {
+            text: i18n("What's On Now")
+            iconName: "media-playback-start"
+            onTriggered: {
+                pageStack.layers.clear();
+                pageStack.clear();
+                pageStack.push("qrc:/NowNextPage.qml");
+            }
+        },
         Kirigami.Action {
             text: i18n("Select Favorites")
             iconName: "rss"
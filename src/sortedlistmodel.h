@@ -0,0 +1,82 @@
+#pragma once
+
+#include <QAbstractListModel>
+
+#include <QVector>
+
+// list model with sorted rows: an update is merged into the rows such that only the changed rows are signaled (keeps the delegates of all others)
+class SortedListModel : public QAbstractListModel
+{
+public:
+    using QAbstractListModel::QAbstractListModel;
+
+protected:
+    // rows become newRows (both sorted by isBefore), a row with the same key (isSameKey) is changed in place if it is not the same (isSame)
+    // a row which is not before the next new one and has another key is gone (e.g. replaced by another one at the same position)
+    template<typename Row, typename IsBefore, typename IsSameKey, typename IsSame>
+    void mergeRows(QVector<Row> &rows, const QVector<Row> &newRows, IsBefore isBefore, IsSameKey isSameKey, IsSame isSame)
+    {
+        int row = 0;
+        int next = 0;
+        int changedFirst = -1; // consecutive changed rows are signaled at once
+        int changedLast = -1;
+        const auto flushChanged = [this, &changedFirst, &changedLast]() {
+            if (changedFirst >= 0) {
+                Q_EMIT dataChanged(index(changedFirst, 0), index(changedLast, 0));
+                changedFirst = changedLast = -1;
+            }
+        };
+
+        while (row < rows.size() || next < newRows.size()) {
+            if (next >= newRows.size()) {
+                // all remaining ones are gone
+                flushChanged();
+                beginRemoveRows(QModelIndex(), row, rows.size() - 1);
+                rows.remove(row, rows.size() - row);
+                endRemoveRows();
+                break;
+            }
+            const Row &newRow = newRows.at(next);
+
+            if (row < rows.size() && isSameKey(rows.at(row), newRow)) {
+                if (!isSame(rows.at(row), newRow)) {
+                    if (changedFirst >= 0 && changedLast != row - 1) {
+                        flushChanged();
+                    }
+                    rows[row] = newRow;
+                    if (changedFirst < 0) {
+                        changedFirst = row;
+                    }
+                    changedLast = row;
+                }
+                ++row;
+                ++next;
+            } else if (row < rows.size() && !isBefore(newRow, rows.at(row))) {
+                // gone
+                flushChanged();
+                int last = row;
+                while (last + 1 < rows.size() && !isSameKey(rows.at(last + 1), newRow) && !isBefore(newRow, rows.at(last + 1))) {
+                    ++last;
+                }
+                beginRemoveRows(QModelIndex(), row, last);
+                rows.remove(row, last - row + 1);
+                endRemoveRows();
+            } else {
+                // new (before the current row or at the end)
+                flushChanged();
+                int last = next;
+                while (last + 1 < newRows.size() && (row >= rows.size() || isBefore(newRows.at(last + 1), rows.at(row)))) {
+                    ++last;
+                }
+                beginInsertRows(QModelIndex(), row, row + last - next);
+                for (int i = next; i <= last; ++i) {
+                    rows.insert(row + i - next, newRows.at(i));
+                }
+                endInsertRows();
+                row += last - next + 1;
+                next = last + 1;
+            }
+        }
+        flushChanged();
+    }
+};
@@ -0,0 +1,90 @@
+#include "startup.h"
+
+#include "database.h"
+#include "tracer.h"
+
+#include <QDebug>
+#include <QQuickWindow>
+#include <QTimer>
+
+namespace
+{
+qint64 lastTraceMark = -1; // [us] tracer time of the previous phase, < 0 if it was not traced
+}
+
+Startup::Startup()
+    : QObject(nullptr)
+{
+    m_timer.start();
+}
+
+void Startup::mark(const QString &phase)
+{
+    qInfo().noquote() << "Startup:" << phase << "after" << m_timer.elapsed() << "ms";
+
+    // the phase is the span since the previous one
+    if (Tracer::isEnabled()) {
+        if (lastTraceMark >= 0) {
+            Tracer::instance().complete("startup", "Startup phase", lastTraceMark, phase);
+        }
+        lastTraceMark = Tracer::instance().now();
+    }
+}
+
+void Startup::openDatabaseAfterFirstFrame(QQuickWindow *window)
+{
+    // frameSwapped is emitted by the render thread
+    m_firstFrameConnection = connect(window, &QQuickWindow::frameSwapped, this, &Startup::onFirstFrame, Qt::QueuedConnection);
+}
+
+void Startup::onFirstFrame()
+{
+    if (m_firstFrame) {
+        return;
+    }
+    m_firstFrame = true;
+    disconnect(m_firstFrameConnection);
+    mark(QStringLiteral("first frame"));
+
+    // every step in its own event loop iteration to keep the window responsive in between
+    QTimer::singleShot(0, this, [this]() {
+        Database::instance().open();
+        mark(QStringLiteral("database opened"));
+
+        m_databaseReady = true;
+        Q_EMIT databaseReadyChanged();
+        mark(QStringLiteral("models loaded"));
+
+        // only old programs are deleted, nothing visible depends on it
+        QTimer::singleShot(0, this, [this]() {
+            Database::instance().cleanup();
+            mark(QStringLiteral("database cleaned up"));
+        });
+    });
+}
+
+void Startup::openDatabase()
+{
+    if (m_databaseReady) {
+        return;
+    }
+    Database::instance().open();
+    Database::instance().cleanup();
+    m_databaseReady = true;
+    Q_EMIT databaseReadyChanged();
+}
+
+bool Startup::isDatabaseReady() const
+{
+    return m_databaseReady;
+}
+
+void Startup::whenDatabaseReady(QObject *context, const std::function<void()> &function)
+{
+    if (m_databaseReady) {
+        function();
+        return;
+    }
+    // ready is set only once
+    connect(this, &Startup::databaseReadyChanged, context, function);
+}
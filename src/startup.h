@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QObject>
+
+#include <QElapsedTimer>
+#include <QString>
+
+#include <functional>
+
+class QQuickWindow;
+
+// startup in phases: the window is shown first, the database is opened after the first frame
+// (models stay empty and show a placeholder until then)
+// logs the time of every phase since the start of main()
+// GUI thread only
+class Startup : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool databaseReady READ isDatabaseReady NOTIFY databaseReadyChanged)
+
+public:
+    static Startup &instance()
+    {
+        static Startup _instance;
+        return _instance;
+    }
+
+    void mark(const QString &phase);
+
+    // opens the database once the window has rendered its first frame
+    void openDatabaseAfterFirstFrame(QQuickWindow *window);
+    // blocking (e.g. command line mode)
+    void openDatabase();
+
+    bool isDatabaseReady() const;
+    // calls function as soon as the database is ready (immediately if it is already)
+    void whenDatabaseReady(QObject *context, const std::function<void()> &function);
+
+Q_SIGNALS:
+    void databaseReadyChanged();
+
+private:
+    Startup();
+
+    void onFirstFrame();
+
+    QElapsedTimer m_timer;
+    QMetaObject::Connection m_firstFrameConnection;
+    bool m_firstFrame = false; // frames queued before disconnecting are ignored
+    bool m_databaseReady = false;
+};
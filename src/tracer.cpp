@@ -0,0 +1,168 @@
+#include "tracer.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+
+namespace
+{
+const int PROCESS_ID = 1;
+}
+
+Tracer::Tracer()
+    : QObject(nullptr)
+{
+}
+
+void Tracer::start(const QString &path)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_enabled) {
+        return;
+    }
+    qDebug() << "Tracing to" << path;
+    m_path = path;
+    m_events.clear();
+    m_timer.start();
+    m_enabled.store(true, std::memory_order_release);
+}
+
+void Tracer::stop()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_enabled) {
+        return;
+    }
+    m_enabled.store(false, std::memory_order_release);
+    if (write()) {
+        qInfo().noquote() << "Wrote" << m_events.size() << "trace events to" << m_path;
+    }
+    m_events.clear();
+}
+
+qint64 Tracer::now() const
+{
+    return m_timer.nsecsElapsed() / 1000;
+}
+
+void Tracer::complete(const char *category, const char *name, qint64 start, const QString &detail)
+{
+    const qint64 end = now();
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_enabled) {
+        return;
+    }
+    Event event;
+    event.m_category = category;
+    event.m_name = name;
+    event.m_detail = detail;
+    event.m_phase = 'X';
+    event.m_timestamp = start;
+    event.m_duration = end - start;
+    event.m_thread = currentThread();
+    event.m_id = 0;
+    m_events.append(event);
+}
+
+void Tracer::async(const char *category, const char *name, quintptr id, qint64 start, const QString &detail)
+{
+    const qint64 end = now();
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_enabled) {
+        return;
+    }
+    Event event;
+    event.m_category = category;
+    event.m_name = name;
+    event.m_detail = detail;
+    event.m_phase = 'b';
+    event.m_timestamp = start;
+    event.m_duration = 0;
+    event.m_thread = currentThread();
+    event.m_id = id;
+    m_events.append(event);
+
+    event.m_detail.clear();
+    event.m_phase = 'e';
+    event.m_timestamp = end;
+    m_events.append(event);
+}
+
+int Tracer::currentThread()
+{
+    const Qt::HANDLE handle = QThread::currentThreadId();
+    auto it = m_threads.constFind(handle);
+    if (it != m_threads.constEnd()) {
+        return it.value();
+    }
+
+    const int index = m_threadNames.size();
+    const QCoreApplication *app = QCoreApplication::instance();
+    if (app && QThread::currentThread() == app->thread()) {
+        m_threadNames.append(QStringLiteral("GUI"));
+    } else if (!QThread::currentThread()->objectName().isEmpty()) {
+        m_threadNames.append(QThread::currentThread()->objectName());
+    } else {
+        m_threadNames.append(QStringLiteral("Thread %1").arg(index));
+    }
+    m_threads.insert(handle, index);
+    return index;
+}
+
+bool Tracer::write() const
+{
+    QSaveFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to write trace" << m_path << ":" << file.errorString();
+        return false;
+    }
+
+    // one event per line (large traces are written without building the whole document in memory)
+    file.write("{\"traceEvents\":[\n");
+    bool first = true;
+    const auto writeEvent = [&file, &first](const QJsonObject &event) {
+        if (!first) {
+            file.write(",\n");
+        }
+        first = false;
+        file.write(QJsonDocument(event).toJson(QJsonDocument::Compact));
+    };
+
+    for (int i = 0; i < m_threadNames.size(); ++i) {
+        QJsonObject event;
+        event.insert(QStringLiteral("name"), QStringLiteral("thread_name"));
+        event.insert(QStringLiteral("ph"), QStringLiteral("M"));
+        event.insert(QStringLiteral("pid"), PROCESS_ID);
+        event.insert(QStringLiteral("tid"), i);
+        event.insert(QStringLiteral("args"), QJsonObject{{QStringLiteral("name"), m_threadNames.at(i)}});
+        writeEvent(event);
+    }
+
+    for (const Event &event : m_events) {
+        QJsonObject object;
+        object.insert(QStringLiteral("name"), QString::fromUtf8(event.m_name));
+        object.insert(QStringLiteral("cat"), QString::fromUtf8(event.m_category));
+        object.insert(QStringLiteral("ph"), QString(QLatin1Char(event.m_phase)));
+        object.insert(QStringLiteral("ts"), event.m_timestamp);
+        object.insert(QStringLiteral("pid"), PROCESS_ID);
+        object.insert(QStringLiteral("tid"), event.m_thread);
+        if (event.m_phase == 'X') {
+            object.insert(QStringLiteral("dur"), event.m_duration);
+        } else {
+            object.insert(QStringLiteral("id"), QString::number(event.m_id, 16));
+        }
+        if (!event.m_detail.isEmpty()) {
+            object.insert(QStringLiteral("args"), QJsonObject{{QStringLiteral("detail"), event.m_detail}});
+        }
+        writeEvent(object);
+    }
+
+    file.write("\n]}\n");
+    return file.commit();
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <QObject>
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+
+// records Chrome trace events (open the file with https://ui.perfetto.dev or chrome://tracing)
+// enabled with --trace <file> or TELLY_SKOUT_TRACE=<file>, a disabled span costs an atomic load only
+// may be used from any thread
+class Tracer : public QObject
+{
+    Q_OBJECT
+
+public:
+    static Tracer &instance()
+    {
+        static Tracer _instance;
+        return _instance;
+    }
+
+    static bool isEnabled()
+    {
+        return instance().m_enabled.load(std::memory_order_acquire);
+    }
+
+    void start(const QString &path);
+    void stop(); // writes the file
+
+    qint64 now() const; // [us] since start()
+    // span on the current thread which started at start (names must be string literals)
+    void complete(const char *category, const char *name, qint64 start, const QString &detail = QString());
+    // span which may overlap others (e.g. network request), shown on its own track
+    void async(const char *category, const char *name, quintptr id, qint64 start, const QString &detail = QString());
+
+private:
+    Tracer();
+
+    struct Event {
+        const char *m_category;
+        const char *m_name;
+        QString m_detail;
+        char m_phase; // 'X' (complete), 'b'/'e' (async begin/end)
+        qint64 m_timestamp; // [us]
+        qint64 m_duration; // [us]
+        int m_thread;
+        quintptr m_id; // async only
+    };
+
+    int currentThread(); // m_mutex must be locked
+    bool write() const; // m_mutex must be locked
+
+    std::atomic<bool> m_enabled{false};
+    QElapsedTimer m_timer;
+    QString m_path;
+
+    QMutex m_mutex; // protects everything below
+    QVector<Event> m_events;
+    QHash<Qt::HANDLE, int> m_threads; // -> index
+    QVector<QString> m_threadNames;
+};
+
+// measures the scope it lives in
+class TraceSpan
+{
+public:
+    TraceSpan(const char *category, const char *name)
+        : m_category(category)
+        , m_name(name)
+        , m_start(Tracer::isEnabled() ? Tracer::instance().now() : -1)
+    {
+    }
+    ~TraceSpan()
+    {
+        if (m_start >= 0) {
+            Tracer::instance().complete(m_category, m_name, m_start, m_detail);
+        }
+    }
+
+    void setDetail(const QString &detail) // e.g. the URL (only stored if tracing is enabled)
+    {
+        if (m_start >= 0) {
+            m_detail = detail;
+        }
+    }
+
+private:
+    Q_DISABLE_COPY(TraceSpan)
+
+    const char *m_category;
+    const char *m_name;
+    const qint64 m_start; // < 0 if disabled
+    QString m_detail;
+};
+
+#define TRACE_SCOPE(category, name) const TraceSpan traceSpan((category), (name))
+#define TRACE_FUNCTION(category) TRACE_SCOPE((category), Q_FUNC_INFO)
@@ -1,6 +1,9 @@
 #include "tvspielfilmfetcher.h"
 
 #include "database.h"
+#include "fetchmetrics.h"
+#include "parserpool.h"
+#include "tracer.h"
 
 #include <KLocalizedString>
 
@@ -12,8 +15,34 @@
 #include <QString>
 #include <QtXml>
 
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+namespace
+{
+// as many as QNetworkAccessManager runs per host at once
+const int MAX_RUNNING_PAGES = 6;
+}
+
 TvSpielfilmFetcher::TvSpielfilmFetcher()
 {
+    connect(&ParserPool::instance(), &ParserPool::available, this, &TvSpielfilmFetcher::startDeferredPages);
+}
+
+QString TvSpielfilmFetcher::name() const
+{
+    return QStringLiteral("tvspielfilm");
+}
+
+bool TvSpielfilmFetcher::handlesUrl(const QUrl &url) const
+{
+    return url.host().endsWith(QLatin1String("tvspielfilm.de"));
+}
+
+bool TvSpielfilmFetcher::isBusy() const
+{
+    return NetworkFetcher::isBusy() || !m_deferredPages.isEmpty();
 }
 
 void TvSpielfilmFetcher::fetchCountries()
@@ -41,41 +70,63 @@ void TvSpielfilmFetcher::fetchCountry(const QString &url, const CountryId &count
             qWarning() << "Error fetching country";
             qWarning() << reply->errorString();
             Q_EMIT errorFetchingCountry(countryId, Error(reply->error(), reply->errorString()));
+            Q_EMIT countryUpdated(countryId);
+            reply->deleteLater();
         } else {
-            QByteArray data = reply->readAll();
+            const QByteArray data = reply->readAll();
+            ParserPool::instance().submit<QVector<ChannelData>>(
+                reply,
+                url,
+                [this, data]() {
+                    return processCountry(data);
+                },
+                [this, countryId, reply](QVector<ChannelData> &channels) {
+                    for (const ChannelData &channel : qAsConst(channels)) {
+                        fetchChannel(channel.m_id, channel.m_name, countryId);
+                    }
+                    Q_EMIT countryUpdated(countryId);
+                    reply->deleteLater();
+                });
+        }
+    });
+}
 
-            QRegularExpression re("<select name=\\\"channel\\\">.*</select>");
-            re.setPatternOptions(QRegularExpression::DotMatchesEverythingOption);
-            QRegularExpressionMatch match = re.match(data);
-            if (match.hasMatch()) {
-                const QString matched = match.captured(0);
+QVector<ChannelData> TvSpielfilmFetcher::processCountry(const QByteArray &data) const
+{
+    TRACE_FUNCTION("parse");
+    QVector<ChannelData> channels;
 
-                QDomDocument channelsXml;
+    QRegularExpression re("<select name=\\\"channel\\\">.*</select>");
+    re.setPatternOptions(QRegularExpression::DotMatchesEverythingOption);
+    QRegularExpressionMatch match = re.match(data);
+    if (match.hasMatch()) {
+        const QString matched = match.captured(0);
 
-                if (!channelsXml.setContent(matched)) {
-                    qWarning() << "Failed to parse XML";
-                }
+        QDomDocument channelsXml;
 
-                QDomNodeList channelNodes = channelsXml.elementsByTagName("option");
+        if (!channelsXml.setContent(matched)) {
+            qWarning() << "Failed to parse XML";
+        }
 
-                for (int i = 0; i < channelNodes.count(); i++) {
-                    QDomNode channelNode = channelNodes.at(i);
-                    if (channelNode.isElement()) {
-                        const QDomNamedNodeMap &attributes = channelNode.attributes();
-                        const ChannelId id = ChannelId(attributes.namedItem("value").toAttr().value());
+        QDomNodeList channelNodes = channelsXml.elementsByTagName("option");
 
-                        // exclude groups (e.g. "alle Sender" or "g:1")
-                        if (id.value().length() > 0 && !id.value().contains("g:")) {
-                            const QString &name = channelNode.toElement().text();
-                            fetchChannel(id, name, countryId);
-                        }
-                    }
+        for (int i = 0; i < channelNodes.count(); i++) {
+            QDomNode channelNode = channelNodes.at(i);
+            if (channelNode.isElement()) {
+                const QDomNamedNodeMap &attributes = channelNode.attributes();
+                const ChannelId id = ChannelId(attributes.namedItem("value").toAttr().value());
+
+                // exclude groups (e.g. "alle Sender" or "g:1")
+                if (id.value().length() > 0 && !id.value().contains("g:")) {
+                    ChannelData channel;
+                    channel.m_id = id;
+                    channel.m_name = channelNode.toElement().text();
+                    channels.append(channel);
                 }
             }
         }
-        delete reply;
-        Q_EMIT countryUpdated(countryId);
-    });
+    }
+    return channels;
 }
 
 void TvSpielfilmFetcher::fetchChannel(const ChannelId &channelId, const QString &name, const CountryId &country)
@@ -106,149 +157,233 @@ void TvSpielfilmFetcher::fetchProgramDescription(const ChannelId &channelId, con
         if (reply->error()) {
             qWarning() << "Error fetching program description";
             qWarning() << reply->errorString();
+            Q_EMIT errorFetchingProgram(programId, Error(reply->error(), reply->errorString()));
+            reply->deleteLater();
         } else {
-            QByteArray data = reply->readAll();
-            processDescription(data, url, programId);
-
-            Q_EMIT channelUpdated(channelId);
+            const QByteArray data = reply->readAll();
+            ParserPool::instance().submit<QString>(
+                reply,
+                url,
+                [data]() {
+                    return TvSpielfilmParser::description(data);
+                },
+                [this, channelId, programId, url, reply](QString &description) {
+                    processDescription(description, url, channelId, programId);
+                    reply->deleteLater();
+                });
         }
-        delete reply;
     });
 }
 
-void TvSpielfilmFetcher::fetchProgram(const ChannelId &channelId)
+void TvSpielfilmFetcher::fetchProgram(const ChannelId &channelId, const ChannelId &providerChannelId, const QVector<QDate> &days)
 {
-    QDate today = QDate::currentDate();
-    QDate yesterday = QDate::currentDate().addDays(-1);
-    QDate tomorrow = QDate::currentDate().addDays(1);
-    QSet<QDate> days{tomorrow, today, yesterday}; // backwards such that we can stop early (see below)
-    for (auto day : days) {
+    QVector<QDate> sortedDays = days;
+    std::sort(sortedDays.begin(), sortedDays.end(), std::greater<QDate>()); // backwards such that we can stop early (see below)
+    QVector<QDate> missingDays;
+    for (const QDate &day : qAsConst(sortedDays)) {
         // check if program is available already
         const QDateTime utcTime(day, QTime(), Qt::UTC);
         const qint64 lastTime = utcTime.addDays(1).toSecsSinceEpoch() - 1;
 
         if (Database::instance().programExists(channelId, lastTime)) {
-            return; // assume that programs from previous days are available
+            break; // assume that programs from previous days are available
         }
+        missingDays.append(day);
+    }
+    if (missingDays.isEmpty()) {
+        Q_EMIT programFetchFinished(channelId);
+        return;
+    }
 
+    const std::shared_ptr<int> pendingDays = std::make_shared<int>(missingDays.size());
+    for (const QDate &day : qAsConst(missingDays)) {
         // https://www.tvspielfilm.de/tv-programm/sendungen/?date=2021-11-09&time=day&channel=ARD
-        const QString url = "https://www.tvspielfilm.de/tv-programm/sendungen/?time=day&channel=" + channelId.value();
-        const QString urlDay = url + "&date=" + day.toString("yyyy-MM-dd") + "&page=1";
-        QVector<ProgramData> programs;
-        fetchProgram(channelId, urlDay, programs);
+        const QString url = "https://www.tvspielfilm.de/tv-programm/sendungen/?time=day&channel=" + providerChannelId.value();
+        const QString urlDay = url + "&date=" + day.toString("yyyy-MM-dd");
+        fetchProgramDay(channelId, urlDay, [this, channelId, pendingDays]() {
+            if (--*pendingDays == 0) {
+                Q_EMIT programFetchFinished(channelId);
+            }
+        });
     }
 }
 
-void TvSpielfilmFetcher::fetchProgram(const ChannelId &channelId, const QString &url, QVector<ProgramData> &programs)
+// programs of all pages of one day (stored at once when all pages are available)
+namespace
 {
-    qDebug() << "Starting to fetch program for " << channelId.value() << "(" << url << ")";
+struct ParsedPage {
+    int m_pageCount = 1;
+    QVector<ProgramData> m_programs;
+};
+}
 
-    QNetworkRequest request((QUrl(url)));
-    QNetworkReply *reply = get(request);
-    connect(reply, &QNetworkReply::finished, this, [this, channelId, url, programs, reply]() {
-        if (reply->error()) {
+struct TvSpielfilmFetcher::ProgramPages {
+    QVector<QVector<ProgramData>> m_programs; // per page
+    int m_pending = 0;
+    bool m_failed = false;
+    std::function<void()> m_finished; // day done (stored or failed)
+};
+
+void TvSpielfilmFetcher::fetchProgramDay(const ChannelId &channelId, const QString &url, const std::function<void()> &finished)
+{
+    // the first page tells how many pages there are, the remaining pages are fetched in parallel
+    const std::shared_ptr<ProgramPages> pages = std::make_shared<ProgramPages>();
+    pages->m_finished = finished;
+    fetchProgramPage(channelId, url, 1, pages);
+}
+
+void TvSpielfilmFetcher::fetchProgramPage(const ChannelId &channelId, const QString &url, int page, const std::shared_ptr<ProgramPages> &pages)
+{
+    // every page body is kept until it is parsed: do not request more while the parsers are behind
+    if (ParserPool::instance().isSaturated() || m_runningPages >= MAX_RUNNING_PAGES) {
+        m_deferredPages.enqueue([this, channelId, url, page, pages]() {
+            fetchProgramPage(channelId, url, page, pages);
+        });
+        return;
+    }
+    ++m_runningPages;
+
+    const QString urlPage = url + "&page=" + QString::number(page);
+    qDebug() << "Starting to fetch program for " << channelId.value() << "(" << urlPage << ")";
+
+    QNetworkRequest request((QUrl(urlPage)));
+    QNetworkReply *reply = get(request, channelId);
+    connect(reply, &QNetworkReply::finished, this, [this, channelId, url, urlPage, page, pages, reply]() {
+        --m_runningPages;
+        if (pages->m_failed) {
+            // error already reported for another page
+            reply->deleteLater();
+        } else if (reply->error()) {
             qWarning() << "Error fetching channel";
             qWarning() << reply->errorString();
+            pages->m_failed = true;
             Q_EMIT errorFetchingChannel(channelId, Error(reply->error(), reply->errorString()));
+            pages->m_finished();
+            reply->deleteLater();
         } else {
-            QByteArray data = reply->readAll();
-            QVector<ProgramData> allPrograms(programs);
-            allPrograms.append(processChannel(data, url, channelId));
-
-            // fetch next page
-            QRegularExpression reNextPage(
-                "<ul class=\\\"pagination__items\\\">.*<a href=\\\"(.*?)\\\"\\s*class=\\\"js-track-link pagination__link pagination__link--next\\\"");
-            reNextPage.setPatternOptions(QRegularExpression::DotMatchesEverythingOption);
-            QRegularExpressionMatch matchNextPage = reNextPage.match(data);
-            if (matchNextPage.hasMatch()) {
-                fetchProgram(channelId, matchNextPage.captured(1), allPrograms);
-            } else {
-                // all pages processed, update DB + GUI
-                Database::instance().addPrograms(allPrograms);
-                Q_EMIT channelUpdated(channelId);
-            }
+            const QByteArray data = reply->readAll();
+            ParserPool::instance().submit<ParsedPage>(
+                reply,
+                urlPage,
+                [this, data, channelId]() -> ParsedPage {
+                    ParsedPage parsedPage;
+                    parsedPage.m_pageCount = TvSpielfilmParser(data).pageCount();
+                    parsedPage.m_programs = processChannel(data, channelId);
+                    return parsedPage;
+                },
+                [this, channelId, url, page, pages, reply](ParsedPage &parsedPage) {
+                    reply->deleteLater();
+                    if (pages->m_failed) {
+                        return;
+                    }
+
+                    if (page == 1) {
+                        pages->m_programs.resize(parsedPage.m_pageCount);
+                        pages->m_pending = parsedPage.m_pageCount;
+                        for (int nextPage = 2; nextPage <= parsedPage.m_pageCount; ++nextPage) {
+                            fetchProgramPage(channelId, url, nextPage, pages);
+                        }
+                    }
+
+                    pages->m_programs[page - 1] = std::move(parsedPage.m_programs);
+                    --pages->m_pending;
+
+                    if (pages->m_pending == 0) {
+                        // all pages processed, update DB + GUI
+                        storeProgramPages(channelId, *pages, reply);
+                        pages->m_finished();
+                    }
+                });
         }
-        delete reply;
+        // after the submit (it may have saturated the ParserPool)
+        startDeferredPages();
     });
 }
 
-QVector<ProgramData> TvSpielfilmFetcher::processChannel(const QString &infoTable, const QString &url, const ChannelId &channelId)
+void TvSpielfilmFetcher::startDeferredPages()
 {
+    while (!m_deferredPages.isEmpty() && !ParserPool::instance().isSaturated() && m_runningPages < MAX_RUNNING_PAGES) {
+        m_deferredPages.dequeue()();
+    }
+}
+
+void TvSpielfilmFetcher::storeProgramPages(const ChannelId &channelId, ProgramPages &pages, QNetworkReply *lastReply)
+{
+    int count = 0;
+    for (const QVector<ProgramData> &programs : pages.m_programs) {
+        count += programs.size();
+    }
+
+    QVector<ProgramData> allPrograms;
+    allPrograms.reserve(count);
+    for (QVector<ProgramData> &programs : pages.m_programs) {
+        for (ProgramData &program : programs) {
+            allPrograms.append(std::move(program));
+        }
+    }
+    pages.m_programs.clear();
+
+    const qint64 databaseTime = Database::instance().busyTime();
+    Database::instance().addPrograms(allPrograms);
+    FetchMetrics::instance().recordStored(lastReply, allPrograms.size(), Database::instance().busyTime() - databaseTime);
+    Q_EMIT channelUpdated(channelId);
+}
+
+QVector<ProgramData> TvSpielfilmFetcher::processChannel(const QByteArray &infoTable, const ChannelId &channelId) const
+{
+    // the time per page is recorded by the ParserPool job (trace and FetchMetrics)
+    TRACE_FUNCTION("parse");
     QVector<ProgramData> programs;
 
-    // column with date and time
-    const QString reTime("<strong>(\\d\\d:\\d\\d) - (\\d\\d:\\d\\d)</strong>");
-    const QString reDate("<span>.*? (\\d\\d\\.\\d\\d\\.)</span>");
-    const QString reDateTimeCol("<td class=\\\"col-2\\\">.*?" + reTime + ".*?" + reDate + ".*?</td>");
-
-    // column with title + description URL
-    const QString reDescriptionUrl("<a href=\\\"(https://www.tvspielfilm.de/tv-programm/sendung/.*?\\.html)\\\"");
-    const QString reTitle("<strong>(.*?)</strong>");
-    const QString reTitleCol("<td class=\\\"col-3\\\">.*?" + reDescriptionUrl + ".*?" + reTitle + ".*?</td>");
-
-    // column with category
-    const QString reCategory("<span>(.*?)</span>");
-    const QString reCategoryCol("<td class=\\\"col-4\\\">.*?" + reCategory + ".*?</td>");
-
-    QRegularExpression reProgram("<tr class=\\\"hover\\\">.*?" + reDateTimeCol + ".*?" + reTitleCol + ".*?" + reCategoryCol + ".*?</tr>");
-    reProgram.setPatternOptions(QRegularExpression::DotMatchesEverythingOption);
-    QRegularExpressionMatchIterator it = reProgram.globalMatch(infoTable);
-    while (it.hasNext()) {
-        QRegularExpressionMatch match = it.next();
-        programs.push_back(processProgram(match, url, channelId, !it.hasNext()));
+    TvSpielfilmParser parser(infoTable);
+    TvSpielfilmParser::Row row;
+    while (parser.nextRow(row)) {
+        programs.push_back(processProgram(row, channelId));
     }
 
     return programs;
 }
 
-ProgramData TvSpielfilmFetcher::processProgram(const QRegularExpressionMatch &programMatch, const QString &url, const ChannelId &channelId, bool isLast)
+ProgramData TvSpielfilmFetcher::processProgram(const TvSpielfilmParser::Row &row, const ChannelId &channelId) const
 {
-    Q_UNUSED(isLast)
-
     ProgramData programData;
 
-    if (programMatch.hasMatch()) {
-        const QString date = programMatch.captured(3);
-        const QDateTime startTime = QDateTime::fromString(QString::number(QDate::currentDate().year()) + date + programMatch.captured(1), "yyyydd.MM.HH:mm");
-        QDateTime stopTime = QDateTime::fromString(QString::number(QDate::currentDate().year()) + date + programMatch.captured(2), "yyyydd.MM.HH:mm");
-        // ends after midnight
-        if (stopTime < startTime) {
-            stopTime = stopTime.addDays(1);
-        }
-        const QString descriptionUrl = programMatch.captured(4);
-        const QString title = programMatch.captured(5);
-        const QString category = programMatch.captured(6);
-
-        // channel + start time can be used as ID
-        const ProgramId programId = ProgramId(channelId.value() + "_" + QString::number(startTime.toSecsSinceEpoch()));
-
-        programData.m_id = programId;
-        programData.m_url = descriptionUrl;
-        programData.m_channelId = channelId;
-        programData.m_startTime = startTime;
-        programData.m_stopTime = stopTime;
-        programData.m_title = title;
-        programData.m_subtitle = "";
-        programData.m_description = "";
-        programData.m_descriptionFetched = false;
-        programData.m_category = category;
-    } else {
-        qWarning() << "Failed to parse program " << url;
+    // the parser guarantees the format ("HH:mm", "dd.MM.")
+    const auto twoDigits = [](const char *digits) {
+        return (digits[0] - '0') * 10 + (digits[1] - '0');
+    };
+    const QDate date(QDate::currentDate().year(), twoDigits(row.m_date.m_begin + 3), twoDigits(row.m_date.m_begin));
+    const QDateTime startTime(date, QTime(twoDigits(row.m_startTime.m_begin), twoDigits(row.m_startTime.m_begin + 3)));
+    QDateTime stopTime(date, QTime(twoDigits(row.m_stopTime.m_begin), twoDigits(row.m_stopTime.m_begin + 3)));
+    // ends after midnight
+    if (stopTime < startTime) {
+        stopTime = stopTime.addDays(1);
     }
 
+    // channel + start time can be used as ID
+    const ProgramId programId = ProgramId(channelId.value() + "_" + QString::number(startTime.toSecsSinceEpoch()));
+
+    programData.m_id = programId;
+    programData.m_url = row.m_descriptionUrl.toString();
+    programData.m_channelId = channelId;
+    programData.m_startTime = startTime;
+    programData.m_stopTime = stopTime;
+    programData.m_title = row.m_title.toString();
+    programData.m_subtitle = "";
+    programData.m_description = "";
+    programData.m_descriptionFetched = false;
+    programData.m_category = row.m_category.toString();
+
     return programData;
 }
 
-void TvSpielfilmFetcher::processDescription(const QString &descriptionPage, const QString &url, const ProgramId &programId)
+void TvSpielfilmFetcher::processDescription(const QString &description, const QString &url, const ChannelId &channelId, const ProgramId &programId)
 {
-    QRegularExpression reDescription("<section class=\\\"broadcast-detail__description\\\">.*?<p>(.*?)</p>");
-    reDescription.setPatternOptions(QRegularExpression::DotMatchesEverythingOption);
-    QRegularExpressionMatch match = reDescription.match(descriptionPage);
-    if (match.hasMatch()) {
-        const QString description = match.captured(1);
-
-        Database::instance().updateProgramDescription(programId, description);
+    // stored in batches by the Fetcher
+    if (!description.isNull()) {
+        Q_EMIT programDescriptionUpdated(channelId, programId, description);
     } else {
         qWarning() << "Failed to parse program description from" << url;
+        Q_EMIT errorFetchingProgram(programId, Error(-1, i18n("Failed to parse program description")));
     }
 }
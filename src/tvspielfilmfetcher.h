@@ -2,7 +2,14 @@
 
 #include "networkfetcher.h"
 
+#include "channeldata.h"
 #include "programdata.h"
+#include "tvspielfilmparser.h"
+
+#include <QQueue>
+
+#include <functional>
+#include <memory>
 
 class TvSpielfilmFetcher : public NetworkFetcher
 {
@@ -11,15 +18,28 @@ public:
     TvSpielfilmFetcher();
     virtual ~TvSpielfilmFetcher() = default;
 
+    QString name() const override;
+    bool handlesUrl(const QUrl &url) const override;
+    bool isBusy() const override;
+
     void fetchCountries() override;
     void fetchCountry(const QString &url, const CountryId &countryId) override;
-    void fetchProgram(const ChannelId &channelId) override;
+    void fetchProgram(const ChannelId &channelId, const ChannelId &providerChannelId, const QVector<QDate> &days) override;
     void fetchProgramDescription(const ChannelId &channelId, const ProgramId &programId, const QString &url) override;
 
 private:
     void fetchChannel(const ChannelId &channelId, const QString &name, const CountryId &country);
-    void fetchProgram(const ChannelId &channelId, const QString &url, QVector<ProgramData> &programs);
-    QVector<ProgramData> processChannel(const QString &infoTable, const QString &url, const ChannelId &channelId);
-    ProgramData processProgram(const QRegularExpressionMatch &programMatch, const QString &url, const ChannelId &channelId, bool isLast);
-    void processDescription(const QString &descriptionPage, const QString &url, const ProgramId &programId);
+    struct ProgramPages;
+    void fetchProgramDay(const ChannelId &channelId, const QString &url, const std::function<void()> &finished);
+    void fetchProgramPage(const ChannelId &channelId, const QString &url, int page, const std::shared_ptr<ProgramPages> &pages);
+    void startDeferredPages();
+    void storeProgramPages(const ChannelId &channelId, ProgramPages &pages, QNetworkReply *lastReply);
+    // process*() except processDescription() are called on the ParserPool (must not access the database)
+    QVector<ChannelData> processCountry(const QByteArray &data) const;
+    QVector<ProgramData> processChannel(const QByteArray &infoTable, const ChannelId &channelId) const;
+    ProgramData processProgram(const TvSpielfilmParser::Row &row, const ChannelId &channelId) const;
+    void processDescription(const QString &description, const QString &url, const ChannelId &channelId, const ProgramId &programId);
+
+    int m_runningPages = 0; // requested, not handed to the ParserPool yet
+    QQueue<std::function<void()>> m_deferredPages; // requested later (backpressure)
 };
@@ -0,0 +1,206 @@
+#include "tvspielfilmparser.h"
+
+#include <QDebug>
+#include <QtAlgorithms>
+#include <QtEndian>
+#include <QtGlobal>
+
+#include <cstring>
+
+namespace
+{
+const quint64 ONES = 0x0101010101010101ULL;
+const quint64 HIGH_BITS = 0x8080808080808080ULL;
+
+// marks (at least) every zero byte, may mark additional bytes above a zero byte (must be verified by the caller)
+inline quint64 zeroBytes(quint64 value)
+{
+    return (value - ONES) & ~value & HIGH_BITS;
+}
+
+bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// "HH:MM - HH:MM"
+bool isTimeRange(const TvSpielfilmParser::Span &span)
+{
+    const char *s = span.m_begin;
+    return span.size() == 13 && isDigit(s[0]) && isDigit(s[1]) && s[2] == ':' && isDigit(s[3]) && isDigit(s[4]) && s[5] == ' ' && s[6] == '-' && s[7] == ' '
+        && isDigit(s[8]) && isDigit(s[9]) && s[10] == ':' && isDigit(s[11]) && isDigit(s[12]);
+}
+
+// "dd.MM."
+bool isDate(const char *s)
+{
+    return isDigit(s[0]) && isDigit(s[1]) && s[2] == '.' && isDigit(s[3]) && isDigit(s[4]) && s[5] == '.';
+}
+
+const char URL_PREFIX[] = "https://www.tvspielfilm.de/tv-programm/sendung/";
+
+// sanity limit (a day has a few pages only)
+const int MAX_PAGE_COUNT = 100;
+}
+
+TvSpielfilmParser::TvSpielfilmParser(const QByteArray &page)
+    : m_page(page)
+    , m_position(m_page.constData())
+    , m_end(m_page.constData() + m_page.size())
+{
+}
+
+bool TvSpielfilmParser::nextRow(Row &row)
+{
+    while (m_position < m_end) {
+        const char *rowBegin = find(m_position, m_end, "<tr class=\"hover\">");
+        if (!rowBegin) {
+            m_position = m_end;
+            return false;
+        }
+        const char *rowEnd = find(rowBegin, m_end, "</tr>");
+        if (!rowEnd) {
+            rowEnd = m_end;
+        }
+        m_position = rowEnd;
+
+        if (parseRow(rowBegin, rowEnd, row)) {
+            return true;
+        }
+        qWarning() << "Failed to parse program row" << QString::fromUtf8(rowBegin, static_cast<int>(rowEnd - rowBegin)).left(200);
+    }
+    return false;
+}
+
+bool TvSpielfilmParser::parseRow(const char *begin, const char *end, Row &row) const
+{
+    // column with date and time
+    const Span dateTimeCol = between(begin, end, "<td class=\"col-2\">", "</td>");
+    if (!dateTimeCol.isValid()) {
+        return false;
+    }
+    const Span time = between(dateTimeCol.m_begin, dateTimeCol.m_end, "<strong>", "</strong>");
+    if (!isTimeRange(time)) {
+        return false;
+    }
+    row.m_startTime = Span(time.m_begin, time.m_begin + 5);
+    row.m_stopTime = Span(time.m_begin + 8, time.m_begin + 13);
+
+    // e.g. "<span>Di 09.11.</span>"
+    row.m_date = Span();
+    const char *position = time.m_end;
+    while (!row.m_date.isValid()) {
+        const Span span = between(position, dateTimeCol.m_end, "<span>", "</span>");
+        if (!span.isValid()) {
+            return false;
+        }
+        if (span.size() >= 7 && *(span.m_end - 7) == ' ' && isDate(span.m_end - 6)) {
+            row.m_date = Span(span.m_end - 6, span.m_end);
+        }
+        position = span.m_end;
+    }
+
+    // column with title + description URL
+    const Span titleCol = between(dateTimeCol.m_end, end, "<td class=\"col-3\">", "</td>");
+    if (!titleCol.isValid()) {
+        return false;
+    }
+    const char *url = find(titleCol.m_begin, titleCol.m_end, "<a href=\"https://www.tvspielfilm.de/tv-programm/sendung/");
+    if (!url) {
+        return false;
+    }
+    url += sizeof("<a href=\"") - 1;
+    const char *urlEnd = find(url + sizeof(URL_PREFIX) - 1, titleCol.m_end, "\"");
+    if (!urlEnd || urlEnd - url < 5 || std::memcmp(urlEnd - 5, ".html", 5) != 0) {
+        return false;
+    }
+    row.m_descriptionUrl = Span(url, urlEnd);
+    row.m_title = between(urlEnd, titleCol.m_end, "<strong>", "</strong>");
+    if (!row.m_title.isValid()) {
+        return false;
+    }
+
+    // column with category
+    const Span categoryCol = between(titleCol.m_end, end, "<td class=\"col-4\">", "</td>");
+    if (!categoryCol.isValid()) {
+        return false;
+    }
+    row.m_category = between(categoryCol.m_begin, categoryCol.m_end, "<span>", "</span>");
+    return row.m_category.isValid();
+}
+
+int TvSpielfilmParser::pageCount() const
+{
+    const char *begin = m_page.constData();
+    const char *end = begin + m_page.size();
+
+    const char *pagination = find(begin, end, "<ul class=\"pagination__items\">");
+    if (!pagination) {
+        return 1;
+    }
+    const char *paginationEnd = find(pagination, end, "</ul>");
+    if (!paginationEnd) {
+        paginationEnd = end;
+    }
+
+    // e.g. <a href="...&page=3" ...>
+    int count = 1;
+    for (const char *position = find(pagination, paginationEnd, "page="); position; position = find(position, paginationEnd, "page=")) {
+        position += sizeof("page=") - 1;
+        int page = 0;
+        for (; position < paginationEnd && isDigit(*position) && page < MAX_PAGE_COUNT; ++position) {
+            page = page * 10 + (*position - '0');
+        }
+        count = qMax(count, qMin(page, MAX_PAGE_COUNT));
+    }
+    return count;
+}
+
+QString TvSpielfilmParser::description(const QByteArray &page)
+{
+    const char *begin = page.constData();
+    const char *end = begin + page.size();
+
+    const char *section = find(begin, end, "<section class=\"broadcast-detail__description\">");
+    if (!section) {
+        return QString();
+    }
+    const Span description = between(section, end, "<p>", "</p>");
+    if (!description.isValid()) {
+        return QString();
+    }
+    return description.toString();
+}
+
+const char *TvSpielfilmParser::find(const char *begin, const char *end, const char *marker, int length)
+{
+    if (length <= 0 || end - begin < length) {
+        return nullptr;
+    }
+
+    // compare first and last byte of the marker for 8 positions at once (SWAR), verify the candidates
+    // (much less candidates than with the first byte only, because almost every marker starts with '<')
+    const quint64 first = ONES * static_cast<unsigned char>(marker[0]);
+    const quint64 last = ONES * static_cast<unsigned char>(marker[length - 1]);
+    const char *position = begin;
+    for (; end - position >= length - 1 + 8; position += 8) {
+        const quint64 firstBytes = qFromLittleEndian<quint64>(position);
+        const quint64 lastBytes = qFromLittleEndian<quint64>(position + length - 1);
+        quint64 candidates = zeroBytes(firstBytes ^ first) & zeroBytes(lastBytes ^ last);
+        while (candidates) {
+            const char *candidate = position + qCountTrailingZeroBits(candidates) / 8;
+            if (std::memcmp(candidate, marker, length) == 0) {
+                return candidate;
+            }
+            candidates &= candidates - 1;
+        }
+    }
+
+    // remaining bytes
+    for (; end - position >= length; ++position) {
+        if (*position == marker[0] && std::memcmp(position, marker, length) == 0) {
+            return position;
+        }
+    }
+    return nullptr;
+}
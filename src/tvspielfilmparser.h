@@ -0,0 +1,89 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+// single pass tokenizer for the TV Spielfilm HTML pages
+// works directly on the UTF-8 reply, the tokens only point into the page (nothing is allocated per row)
+class TvSpielfilmParser
+{
+public:
+    struct Span {
+        Span()
+            : m_begin(nullptr)
+            , m_end(nullptr)
+        {
+        }
+        Span(const char *begin, const char *end)
+            : m_begin(begin)
+            , m_end(end)
+        {
+        }
+
+        bool isValid() const
+        {
+            return m_begin != nullptr;
+        }
+        bool isEmpty() const
+        {
+            return m_begin == m_end;
+        }
+        int size() const
+        {
+            return static_cast<int>(m_end - m_begin);
+        }
+        QString toString() const
+        {
+            return QString::fromUtf8(m_begin, size());
+        }
+
+        const char *m_begin;
+        const char *m_end;
+    };
+
+    struct Row {
+        Span m_startTime; // HH:mm
+        Span m_stopTime; // HH:mm
+        Span m_date; // dd.MM.
+        Span m_descriptionUrl;
+        Span m_title;
+        Span m_category;
+    };
+
+    explicit TvSpielfilmParser(const QByteArray &page);
+
+    // returns false if there are no more rows
+    bool nextRow(Row &row);
+
+    int pageCount() const; // highest page linked in the pagination (1 if there is none)
+    static QString description(const QByteArray &page);
+
+private:
+    bool parseRow(const char *begin, const char *end, Row &row) const;
+
+    static const char *find(const char *begin, const char *end, const char *marker, int length);
+    template<int N>
+    static const char *find(const char *begin, const char *end, const char (&marker)[N])
+    {
+        return find(begin, end, marker, N - 1);
+    }
+    // content between the first "open" and the following "close" in [begin, end)
+    template<int N, int M>
+    static Span between(const char *begin, const char *end, const char (&open)[N], const char (&close)[M])
+    {
+        const char *contentBegin = find(begin, end, open);
+        if (!contentBegin) {
+            return Span();
+        }
+        contentBegin += N - 1;
+        const char *contentEnd = find(contentBegin, end, close);
+        if (!contentEnd) {
+            return Span();
+        }
+        return Span(contentBegin, contentEnd);
+    }
+
+    const QByteArray m_page; // keeps the data alive
+    const char *m_position;
+    const char *m_end;
+};
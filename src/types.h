@@ -1,5 +1,6 @@
 #pragma once
 
+#include <QHash>
 #include <QString>
 
 struct ChannelTag {
@@ -44,6 +45,12 @@ private:
     }
 };
 
+template<class Tag>
+inline uint qHash(const QStringId<Tag> &id, uint seed = 0)
+{
+    return qHash(id.value(), seed);
+}
+
 using ChannelId = QStringId<ChannelTag>;
 using CountryId = QStringId<CountryTag>;
 using ProgramId = QStringId<ProgramTag>;
@@ -0,0 +1,455 @@
+#include "xmltvfilefetcher.h"
+
+#include "database.h"
+#include "parserpool.h"
+#include "xmltvshards.h"
+
+#include <KCompressionDevice>
+#include <KLocalizedString>
+
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QThread>
+#include <QTimer>
+#include <QUrl>
+
+namespace
+{
+// amount of (uncompressed) data which is parsed at once
+const qint64 CHUNK_SIZE = 4 * 1024 * 1024;
+// programs which are stored in a single transaction
+const int TRANSACTION_SIZE = 50000;
+// shards which are parsed (or wait to be stored) at once
+const int MAX_SHARDS_IN_FLIGHT = 2 * QThread::idealThreadCount();
+}
+
+struct XmlTvFileFetcher::Chunk {
+    XmlTvParser::Batch m_batch;
+    qint64 m_bytesRead = 0; // of the file (i.e. compressed)
+    qint64 m_bytesTotal = 0;
+    bool m_last = false;
+    QString m_error;
+};
+
+struct XmlTvFileFetcher::Import {
+    QString m_path;
+    Request m_request;
+    QSet<ChannelId> m_waitingChannels; // requested while the import was running (and covered by it)
+
+    // worker thread (one chunk at a time)
+    std::unique_ptr<QFile> m_file;
+    std::unique_ptr<KCompressionDevice> m_decompressor;
+    QIODevice *m_device = nullptr;
+    XmlTvParser m_parser;
+
+    // sharded (instead of streamed) import
+    std::shared_ptr<XmlTvShards> m_shards; // read-only after opening
+    int m_nextShard = 0;
+    int m_mergedShards = 0;
+    QMap<int, Chunk> m_parsedShards; // waiting for the previous shards
+
+    // GUI thread
+    QVector<ProgramData> m_programs; // not stored yet
+    QSet<ChannelId> m_updatedChannels;
+    qint64 m_programCount = 0;
+    QString m_error;
+    QElapsedTimer m_timer;
+};
+
+XmlTvFileFetcher::XmlTvFileFetcher()
+{
+}
+
+QString XmlTvFileFetcher::name() const
+{
+    return QStringLiteral("xmltv.file");
+}
+
+bool XmlTvFileFetcher::handlesUrl(const QUrl &url) const
+{
+    return url.isLocalFile();
+}
+
+bool XmlTvFileFetcher::isBusy() const
+{
+    return !m_pending.isEmpty() || !m_imports.isEmpty();
+}
+
+void XmlTvFileFetcher::fetchCountries()
+{
+    // nothing to be done (files are added by importFile())
+}
+
+void XmlTvFileFetcher::fetchCountry(const QString &url, const CountryId &countryId)
+{
+    qDebug() << "Starting to fetch country (" << countryId.value() << ", " << url << ")";
+
+    // channels only (stops at the first program)
+    Request channels;
+    channels.m_countryId = countryId;
+    request(QUrl(url).toLocalFile(), channels);
+}
+
+void XmlTvFileFetcher::fetchProgram(const ChannelId &channelId, const ChannelId &providerChannelId, const QVector<QDate> &days)
+{
+    Q_UNUSED(days)
+
+    // the file does not change (contains all days), nothing to do if it has been imported already
+    const QDateTime utcTime(QDate::currentDate().addDays(1), QTime(), Qt::UTC);
+    if (Database::instance().programExists(channelId, utcTime.addDays(1).toSecsSinceEpoch() - 1)) {
+        Q_EMIT programFetchFinished(channelId);
+        return;
+    }
+
+    const QString path = QUrl(Database::instance().channel(providerChannelId).m_url).toLocalFile();
+    if (path.isEmpty()) {
+        Q_EMIT errorFetchingChannel(channelId, Error(-1, i18n("Unknown channel")));
+        Q_EMIT programFetchFinished(channelId);
+        return;
+    }
+    qDebug() << "Starting to fetch program for " << channelId.value() << "(" << path << ")";
+
+    const std::shared_ptr<Import> running = m_imports.value(path);
+    if ((running && running->m_waitingChannels.contains(channelId)) || m_pending.value(path).m_channels.value(providerChannelId) == channelId) {
+        // requested already (the file contains all days), that request finishes the channel
+        Q_EMIT programFetchFinished(channelId);
+        return;
+    }
+    if (running && running->m_request.m_allPrograms) {
+        running->m_waitingChannels.insert(channelId);
+        return;
+    }
+
+    Request programs;
+    programs.m_channels.insert(providerChannelId, channelId);
+    request(path, programs);
+}
+
+void XmlTvFileFetcher::fetchProgramDescription(const ChannelId &channelId, const ProgramId &programId, const QString &url)
+{
+    Q_UNUSED(url)
+
+    // already imported as part of the program, report it (as if it had been fetched) so that the request is done
+    Q_EMIT programDescriptionUpdated(channelId, programId, Database::instance().programDescription(programId));
+}
+
+void XmlTvFileFetcher::importFile(const QString &path)
+{
+    const QFileInfo fileInfo(path);
+    if (!fileInfo.isFile()) {
+        qWarning() << "Cannot import" << path << "(no such file)";
+        Q_EMIT errorFetching(Error(-1, i18n("Cannot import %1", path)));
+        return;
+    }
+
+    const QString filePath = fileInfo.absoluteFilePath();
+    const CountryId countryId = CountryId("xmltv.file:" + filePath);
+    Q_EMIT startedFetchingCountry(countryId);
+    Database::instance().addCountry(countryId, fileInfo.fileName(), QUrl::fromLocalFile(filePath).toString());
+    Q_EMIT countryUpdated(countryId);
+
+    Request all;
+    all.m_countryId = countryId;
+    all.m_allPrograms = true;
+    request(filePath, all);
+}
+
+void XmlTvFileFetcher::request(const QString &path, const Request &request)
+{
+    const bool scheduled = m_pending.contains(path) || m_imports.contains(path);
+
+    Request &pending = m_pending[path];
+    if (request.m_countryId.value().size() > 0) {
+        pending.m_countryId = request.m_countryId;
+    }
+    pending.m_allPrograms = pending.m_allPrograms || request.m_allPrograms;
+    for (auto it = request.m_channels.constBegin(); it != request.m_channels.constEnd(); ++it) {
+        pending.m_channels.insert(it.key(), it.value());
+    }
+
+    // collect the requests of this event loop iteration (e.g. all favorites) and read the file only once
+    if (!scheduled) {
+        QTimer::singleShot(0, this, [this, path]() {
+            startImport(path);
+        });
+    }
+}
+
+void XmlTvFileFetcher::startImport(const QString &path)
+{
+    if (m_imports.contains(path) || !m_pending.contains(path)) {
+        return;
+    }
+
+    std::shared_ptr<Import> import = std::make_shared<Import>();
+    import->m_path = path;
+    import->m_request = m_pending.take(path);
+    import->m_timer.start();
+    m_imports.insert(path, import);
+
+    qDebug() << "Starting to import" << path;
+    // programs of uncompressed files are parsed in parallel (a compressed file can only be read sequentially)
+    const bool programs = import->m_request.m_allPrograms || !import->m_request.m_channels.isEmpty();
+    if (programs && !path.endsWith(QLatin1String(".gz"))) {
+        importShards(import);
+    } else {
+        importChunk(import);
+    }
+}
+
+void XmlTvFileFetcher::importChunk(const std::shared_ptr<Import> &import)
+{
+    ParserPool::instance().submit<Chunk>(
+        this,
+        import->m_path,
+        [import]() {
+            return readChunk(*import);
+        },
+        [this, import](Chunk &chunk) {
+            // parse the next chunk while this one is stored
+            if (!chunk.m_last) {
+                importChunk(import);
+            }
+            storeChunk(*import, chunk);
+            if (chunk.m_last) {
+                finishImport(import);
+            }
+        });
+}
+
+XmlTvFileFetcher::Chunk XmlTvFileFetcher::readChunk(Import &import)
+{
+    Chunk chunk;
+
+    if (!import.m_device) {
+        import.m_file.reset(new QFile(import.m_path));
+        if (!import.m_file->open(QIODevice::ReadOnly)) {
+            chunk.m_error = import.m_file->errorString();
+            chunk.m_last = true;
+            return chunk;
+        }
+        import.m_device = import.m_file.get();
+
+        if (import.m_path.endsWith(QLatin1String(".gz"))) {
+            import.m_decompressor.reset(new KCompressionDevice(import.m_file.get(), false, KCompressionDevice::GZip));
+            if (!import.m_decompressor->open(QIODevice::ReadOnly)) {
+                chunk.m_error = import.m_decompressor->errorString();
+                chunk.m_last = true;
+                return chunk;
+            }
+            import.m_device = import.m_decompressor.get();
+        }
+    }
+
+    const QByteArray data = import.m_device->read(CHUNK_SIZE);
+    if (data.isEmpty() && !import.m_device->atEnd()) {
+        chunk.m_error = import.m_device->errorString();
+    }
+    import.m_parser.addData(data);
+
+    chunk.m_last = data.isEmpty() || import.m_device->atEnd() || !chunk.m_error.isEmpty();
+    if (chunk.m_last) {
+        import.m_parser.finish();
+        if (chunk.m_error.isEmpty() && import.m_parser.hasError()) {
+            chunk.m_error = import.m_parser.errorString();
+        }
+    }
+    // channels come first in XMLTV, stop at the first program if no programs are requested
+    if (!import.m_request.m_allPrograms && import.m_request.m_channels.isEmpty() && import.m_parser.programCount() > 0) {
+        chunk.m_last = true;
+    }
+
+    chunk.m_batch = import.m_parser.takeBatch();
+    chunk.m_bytesRead = import.m_file->pos();
+    chunk.m_bytesTotal = import.m_file->size();
+
+    if (chunk.m_last) {
+        import.m_decompressor.reset();
+        import.m_file.reset();
+        import.m_device = nullptr;
+    }
+    return chunk;
+}
+
+void XmlTvFileFetcher::importShards(const std::shared_ptr<Import> &import)
+{
+    // split + channels (header) first, then all shards
+    ParserPool::instance().submit<Chunk>(
+        this,
+        import->m_path,
+        [import]() -> Chunk {
+            Chunk chunk;
+            std::shared_ptr<XmlTvShards> shards = std::make_shared<XmlTvShards>(import->m_path);
+            if (!shards->open(QThread::idealThreadCount())) {
+                chunk.m_error = shards->errorString();
+                chunk.m_last = true;
+                return chunk;
+            }
+            chunk.m_batch = shards->parseHeader(&chunk.m_error);
+            chunk.m_bytesTotal = shards->size();
+            chunk.m_last = shards->count() == 0;
+            import->m_shards = shards;
+            return chunk;
+        },
+        [this, import](Chunk &chunk) {
+            storeChunk(*import, chunk);
+            if (chunk.m_last) {
+                finishImport(import);
+            } else {
+                mergeShards(import);
+            }
+        });
+}
+
+void XmlTvFileFetcher::parseShard(const std::shared_ptr<Import> &import)
+{
+    const int shard = import->m_nextShard++;
+    ParserPool::instance().submit<Chunk>(
+        this,
+        import->m_path + "#" + QString::number(shard),
+        [import, shard]() -> Chunk {
+            const XmlTvShards &shards = *import->m_shards;
+            Chunk chunk;
+            chunk.m_batch = shards.parse(shard, &chunk.m_error);
+            chunk.m_bytesRead = shards.end(shard);
+            chunk.m_bytesTotal = shards.size();
+            chunk.m_last = shard == shards.count() - 1;
+            return chunk;
+        },
+        [this, import, shard](Chunk &chunk) {
+            import->m_parsedShards.insert(shard, std::move(chunk));
+            mergeShards(import);
+        });
+}
+
+void XmlTvFileFetcher::mergeShards(const std::shared_ptr<Import> &import)
+{
+    // store in file order (shards finish in any order)
+    while (!import->m_parsedShards.isEmpty() && import->m_parsedShards.firstKey() == import->m_mergedShards) {
+        Chunk chunk = import->m_parsedShards.take(import->m_mergedShards);
+        ++import->m_mergedShards;
+        storeChunk(*import, chunk);
+        if (chunk.m_last) {
+            finishImport(import);
+            return;
+        }
+    }
+
+    // bounded memory: do not parse ahead too far while shards are waiting to be stored
+    while (import->m_nextShard < import->m_shards->count() && import->m_nextShard - import->m_mergedShards < MAX_SHARDS_IN_FLIGHT) {
+        parseShard(import);
+    }
+}
+
+void XmlTvFileFetcher::storeChunk(Import &import, Chunk &chunk)
+{
+    const Request &request = import.m_request;
+
+    // channels in bulk (one transaction)
+    if (request.m_countryId.value().size() > 0 && !chunk.m_batch.m_channels.isEmpty()) {
+        const QString url = QUrl::fromLocalFile(import.m_path).toString();
+        QVector<ChannelData> newChannels;
+        for (ChannelData &channel : chunk.m_batch.m_channels) {
+            if (!Database::instance().channelExists(channel.m_id)) {
+                channel.m_url = url;
+                Q_EMIT startedFetchingChannel(channel.m_id);
+                newChannels.append(channel);
+            }
+        }
+        Database::instance().addChannels(newChannels, request.m_countryId);
+    }
+
+    if (request.m_allPrograms) {
+        for (ProgramData &program : chunk.m_batch.m_programs) {
+            import.m_updatedChannels.insert(program.m_channelId);
+            import.m_programs.append(std::move(program));
+        }
+    } else if (!request.m_channels.isEmpty()) {
+        for (ProgramData &program : chunk.m_batch.m_programs) {
+            const auto it = request.m_channels.constFind(program.m_channelId);
+            if (it == request.m_channels.constEnd()) {
+                continue;
+            }
+            // fetched as fallback for a channel of another provider: store the programs for that channel
+            if (it.value() != program.m_channelId) {
+                program.m_id = ProgramId(it.value().value() + "_" + QString::number(program.m_startTime.toSecsSinceEpoch()));
+                program.m_channelId = it.value();
+            }
+            import.m_updatedChannels.insert(program.m_channelId);
+            import.m_programs.append(std::move(program));
+        }
+    }
+    chunk.m_batch = XmlTvParser::Batch();
+
+    if (import.m_programs.size() >= TRANSACTION_SIZE) {
+        storePrograms(import);
+    }
+
+    if (!chunk.m_error.isEmpty()) {
+        import.m_error = chunk.m_error;
+    }
+    Q_EMIT importProgress(import.m_path, chunk.m_bytesRead, chunk.m_bytesTotal);
+}
+
+void XmlTvFileFetcher::storePrograms(Import &import)
+{
+    if (import.m_programs.isEmpty()) {
+        return;
+    }
+    Database::instance().addPrograms(import.m_programs);
+    import.m_programCount += import.m_programs.size();
+    import.m_programs.clear();
+}
+
+void XmlTvFileFetcher::finishImport(const std::shared_ptr<Import> &import)
+{
+    storePrograms(*import);
+    m_imports.remove(import->m_path);
+
+    const Request &request = import->m_request;
+    if (!import->m_error.isEmpty()) {
+        qWarning() << "Error importing" << import->m_path;
+        qWarning() << import->m_error;
+        const Error error(-1, import->m_error);
+        if (request.m_countryId.value().size() > 0) {
+            Q_EMIT errorFetchingCountry(request.m_countryId, error);
+        }
+        for (const ChannelId &channelId : request.m_channels) {
+            Q_EMIT errorFetchingChannel(channelId, error);
+        }
+        for (const ChannelId &channelId : qAsConst(import->m_waitingChannels)) {
+            Q_EMIT errorFetchingChannel(channelId, error);
+        }
+    } else {
+        qDebug() << "Imported" << import->m_programCount << "programs from" << import->m_path << "in" << import->m_timer.elapsed() << "ms";
+
+        for (const ChannelId &channelId : request.m_channels) {
+            import->m_updatedChannels.insert(channelId);
+        }
+        import->m_updatedChannels.unite(import->m_waitingChannels);
+        for (const ChannelId &channelId : qAsConst(import->m_updatedChannels)) {
+            Q_EMIT channelUpdated(channelId);
+        }
+    }
+
+    for (const ChannelId &channelId : request.m_channels) {
+        Q_EMIT programFetchFinished(channelId);
+    }
+    for (const ChannelId &channelId : qAsConst(import->m_waitingChannels)) {
+        Q_EMIT programFetchFinished(channelId);
+    }
+
+    if (request.m_countryId.value().size() > 0) {
+        Q_EMIT countryUpdated(request.m_countryId);
+    }
+    Q_EMIT importFinished(import->m_path, import->m_programCount);
+
+    // requests which came in while the file was read
+    if (m_pending.contains(import->m_path)) {
+        startImport(import->m_path);
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "fetcherimpl.h"
+
+#include "xmltvparser.h"
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+
+#include <memory>
+
+// imports XMLTV files from the local disk (plain or gzip compressed, e.g. dumps of own grabbers)
+// the file is streamed chunk by chunk, i.e. the memory usage does not depend on the file size
+// uncompressed files are split into shards instead which are parsed in parallel (and stored in order)
+class XmlTvFileFetcher : public FetcherImpl
+{
+    Q_OBJECT
+public:
+    XmlTvFileFetcher();
+    virtual ~XmlTvFileFetcher() = default;
+
+    QString name() const override;
+    bool handlesUrl(const QUrl &url) const override;
+    bool isBusy() const override;
+
+    void fetchCountries() override;
+    void fetchCountry(const QString &url, const CountryId &countryId) override;
+    void fetchProgram(const ChannelId &channelId, const ChannelId &providerChannelId, const QVector<QDate> &days) override;
+    void fetchProgramDescription(const ChannelId &channelId, const ProgramId &programId, const QString &url) override;
+
+    // adds the file as country with all its channels and programs
+    void importFile(const QString &path);
+
+Q_SIGNALS:
+    void importProgress(const QString &path, qint64 bytesRead, qint64 bytesTotal);
+    void importFinished(const QString &path, qint64 programCount);
+
+private:
+    // what shall be imported from a file (requests which arrive together are served by a single pass)
+    struct Request {
+        CountryId m_countryId; // add the channels to this country (if valid)
+        bool m_allPrograms = false;
+        QHash<ChannelId, ChannelId> m_channels; // provider channel ID (in the file) -> channel ID (programs of these channels only)
+    };
+    struct Import;
+    struct Chunk;
+
+    void request(const QString &path, const Request &request);
+    void startImport(const QString &path);
+    void importChunk(const std::shared_ptr<Import> &import);
+    static Chunk readChunk(Import &import); // worker thread
+    void importShards(const std::shared_ptr<Import> &import);
+    void parseShard(const std::shared_ptr<Import> &import);
+    void mergeShards(const std::shared_ptr<Import> &import);
+    void storeChunk(Import &import, Chunk &chunk);
+    void storePrograms(Import &import);
+    void finishImport(const std::shared_ptr<Import> &import);
+
+    QHash<QString, Request> m_pending; // file -> not started yet
+    QHash<QString, std::shared_ptr<Import>> m_imports; // file -> running
+};
@@ -0,0 +1,251 @@
+#include "xmltvparser.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QStringRef>
+
+namespace
+{
+int number(const QStringRef &value, int position, int length, bool &ok)
+{
+    int result = 0;
+    for (int i = position; i < position + length; ++i) {
+        const int digit = value.at(i).digitValue();
+        if (digit < 0) {
+            ok = false;
+            return 0;
+        }
+        result = result * 10 + digit;
+    }
+    return result;
+}
+}
+
+XmlTvParser::XmlTvParser()
+    : m_finished(false)
+    , m_field(Field::None)
+    , m_fieldDepth(0)
+    , m_inCountry(false)
+    , m_inChannel(false)
+    , m_inProgram(false)
+    , m_programCount(0)
+{
+}
+
+void XmlTvParser::addData(const QByteArray &data)
+{
+    if (data.isEmpty()) {
+        return;
+    }
+    m_reader.addData(data);
+    parse();
+}
+
+void XmlTvParser::finish()
+{
+    m_finished = true;
+    parse();
+}
+
+bool XmlTvParser::hasError() const
+{
+    // running out of data is expected until the last chunk was added
+    if (m_reader.error() == QXmlStreamReader::PrematureEndOfDocumentError) {
+        return m_finished;
+    }
+    return m_reader.hasError();
+}
+
+QString XmlTvParser::errorString() const
+{
+    return m_reader.errorString();
+}
+
+QVector<CountryData> XmlTvParser::takeCountries()
+{
+    QVector<CountryData> countries;
+    countries.swap(m_countries);
+    return countries;
+}
+
+QVector<ChannelData> XmlTvParser::takeChannels()
+{
+    QVector<ChannelData> channels;
+    channels.swap(m_channels);
+    return channels;
+}
+
+QVector<ProgramData> XmlTvParser::takePrograms()
+{
+    QVector<ProgramData> programs;
+    programs.swap(m_programs);
+    return programs;
+}
+
+XmlTvParser::Batch XmlTvParser::takeBatch()
+{
+    Batch batch;
+    batch.m_countries = takeCountries();
+    batch.m_channels = takeChannels();
+    batch.m_programs = takePrograms();
+    return batch;
+}
+
+qint64 XmlTvParser::programCount() const
+{
+    return m_programCount;
+}
+
+QDateTime XmlTvParser::parseTime(const QStringRef &time)
+{
+    // e.g. "20210729053000 +0000" (offset is optional)
+    // parsed by hand because QDateTime::fromString() is expensive for the amount of programs in an XMLTV file
+    if (time.size() < 14) {
+        return QDateTime();
+    }
+
+    bool ok = true;
+    const QDate date(number(time, 0, 4, ok), number(time, 4, 2, ok), number(time, 6, 2, ok));
+    const QTime clock(number(time, 8, 2, ok), number(time, 10, 2, ok), number(time, 12, 2, ok));
+    if (!ok) {
+        return QDateTime();
+    }
+    QDateTime dateTime(date, clock, Qt::UTC);
+
+    const QStringRef offset = time.mid(14).trimmed();
+    if (offset.size() == 5 && (offset.at(0) == QLatin1Char('+') || offset.at(0) == QLatin1Char('-'))) {
+        const int offsetSecs = number(offset, 1, 2, ok) * 3600 + number(offset, 3, 2, ok) * 60;
+        if (ok) {
+            dateTime = dateTime.addSecs(offset.at(0) == QLatin1Char('+') ? -offsetSecs : offsetSecs);
+        }
+    }
+    return dateTime;
+}
+
+void XmlTvParser::parse()
+{
+    while (!m_reader.atEnd()) {
+        switch (m_reader.readNext()) {
+        case QXmlStreamReader::StartElement:
+            startElement();
+            break;
+        case QXmlStreamReader::EndElement:
+            endElement();
+            break;
+        case QXmlStreamReader::Characters:
+            if (m_field != Field::None) {
+                m_text += m_reader.text();
+            }
+            break;
+        case QXmlStreamReader::Invalid:
+            // wait for more data (premature end) or give up (real error)
+            if (m_reader.error() != QXmlStreamReader::PrematureEndOfDocumentError || m_finished) {
+                qWarning() << "Failed to parse XML:" << m_reader.errorString();
+            }
+            return;
+        default:
+            break;
+        }
+    }
+}
+
+void XmlTvParser::startElement()
+{
+    // nested markup in a text element (e.g. a description) is not interpreted
+    if (m_field != Field::None) {
+        ++m_fieldDepth;
+        return;
+    }
+
+    const QStringRef name = m_reader.name();
+    const QXmlStreamAttributes attributes = m_reader.attributes();
+
+    if (m_inProgram) {
+        if (name == QLatin1String("title") && m_program.m_title.isEmpty()) {
+            m_field = Field::Title;
+        } else if (name == QLatin1String("sub-title") && m_program.m_subtitle.isEmpty()) {
+            m_field = Field::SubTitle;
+        } else if (name == QLatin1String("desc") && m_program.m_description.isEmpty()) {
+            m_field = Field::Description;
+        } else if (name == QLatin1String("category") && m_program.m_category.isEmpty()) {
+            m_field = Field::Category;
+        }
+    } else if (m_inChannel) {
+        if (name == QLatin1String("display-name") && m_channel.m_name.isEmpty()) {
+            m_field = Field::DisplayName;
+        } else if (name == QLatin1String("icon") && m_channel.m_image.isEmpty()) {
+            m_channel.m_image = attributes.value(QLatin1String("src")).toString();
+        }
+    } else if (name == QLatin1String("programme")) {
+        m_inProgram = true;
+        m_program = ProgramData();
+        m_program.m_channelId = ChannelId(attributes.value(QLatin1String("channel")).toString());
+        m_program.m_startTime = parseTime(attributes.value(QLatin1String("start")));
+        m_program.m_stopTime = parseTime(attributes.value(QLatin1String("stop")));
+    } else if (name == QLatin1String("channel")) {
+        m_inChannel = true;
+        m_channel = ChannelData();
+        m_channel.m_id = ChannelId(attributes.value(QLatin1String("id")).toString());
+    } else if (name == QLatin1String("country")) {
+        m_inCountry = true;
+        m_country = CountryData();
+        m_country.m_id = CountryId(attributes.value(QLatin1String("id")).toString());
+        m_field = Field::CountryName;
+    }
+    m_text.clear();
+}
+
+void XmlTvParser::endElement()
+{
+    if (m_fieldDepth > 0) {
+        --m_fieldDepth;
+        return;
+    }
+    if (m_field != Field::None) {
+        storeField();
+        m_field = Field::None;
+    }
+
+    const QStringRef name = m_reader.name();
+    if (m_inProgram && name == QLatin1String("programme")) {
+        m_inProgram = false;
+        // channel + start time can be used as ID
+        m_program.m_id = ProgramId(m_program.m_channelId.value() + "_" + QString::number(m_program.m_startTime.toSecsSinceEpoch()));
+        m_program.m_descriptionFetched = true;
+        m_programs.append(m_program);
+        ++m_programCount;
+    } else if (m_inChannel && name == QLatin1String("channel")) {
+        m_inChannel = false;
+        m_channels.append(m_channel);
+    } else if (m_inCountry && name == QLatin1String("country")) {
+        m_inCountry = false;
+        m_countries.append(m_country);
+    }
+}
+
+void XmlTvParser::storeField()
+{
+    switch (m_field) {
+    case Field::CountryName:
+        m_country.m_name = m_text;
+        break;
+    case Field::DisplayName:
+        m_channel.m_name = m_text;
+        break;
+    case Field::Title:
+        m_program.m_title = m_text;
+        break;
+    case Field::SubTitle:
+        m_program.m_subtitle = m_text;
+        break;
+    case Field::Description:
+        m_program.m_description = m_text;
+        break;
+    case Field::Category:
+        m_program.m_category = m_text;
+        break;
+    case Field::None:
+        break;
+    }
+    m_text.clear();
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "channeldata.h"
+#include "countrydata.h"
+#include "programdata.h"
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <QXmlStreamReader>
+
+class QDateTime;
+class QStringRef;
+
+// incremental XMLTV parser
+// feed the data chunk by chunk (e.g. whenever a network reply has new data) and take the parsed items in between
+// only the items which have not been taken yet are kept in memory
+class XmlTvParser
+{
+public:
+    struct Batch {
+        QVector<CountryData> m_countries;
+        QVector<ChannelData> m_channels;
+        QVector<ProgramData> m_programs;
+    };
+
+    XmlTvParser();
+    ~XmlTvParser() = default;
+
+    void addData(const QByteArray &data);
+    void finish(); // call after the last chunk was added
+    bool hasError() const;
+    QString errorString() const;
+
+    QVector<CountryData> takeCountries();
+    QVector<ChannelData> takeChannels();
+    QVector<ProgramData> takePrograms();
+    Batch takeBatch(); // everything parsed since the last take
+    qint64 programCount() const; // all programs parsed so far (including the ones already taken)
+
+    static QDateTime parseTime(const QStringRef &time);
+
+private:
+    enum class Field { None, CountryName, DisplayName, Title, SubTitle, Description, Category };
+
+    void parse();
+    void startElement();
+    void endElement();
+    void storeField();
+
+    QXmlStreamReader m_reader;
+    bool m_finished;
+
+    Field m_field;
+    int m_fieldDepth;
+    QString m_text;
+
+    bool m_inCountry;
+    bool m_inChannel;
+    bool m_inProgram;
+    CountryData m_country;
+    ChannelData m_channel;
+    ProgramData m_program;
+
+    QVector<CountryData> m_countries;
+    QVector<ChannelData> m_channels;
+    QVector<ProgramData> m_programs;
+    qint64 m_programCount;
+};
@@ -1,7 +1,10 @@
 #include "xmltvsefetcher.h"
 
 #include "database.h"
+#include "fetchmetrics.h"
+#include "parserpool.h"
 #include "programdata.h"
+#include "tracer.h"
 
 #include <QDateTime>
 #include <QDebug>
@@ -9,93 +12,77 @@
 #include <QNetworkRequest>
 #include <QStandardPaths>
 #include <QString>
-#include <QtXml>
+
+namespace
+{
+const qint64 READ_BUFFER_SIZE = 1024 * 1024;
+}
 
 XmlTvSeFetcher::XmlTvSeFetcher()
 {
 }
 
+QString XmlTvSeFetcher::name() const
+{
+    return QStringLiteral("xmltv.se");
+}
+
+bool XmlTvSeFetcher::handlesUrl(const QUrl &url) const
+{
+    return url.host().endsWith(QLatin1String("xmltv.se"));
+}
+
 void XmlTvSeFetcher::fetchCountries()
 {
     // http://xmltv.se/countries.xml
     const QString url = "http://xmltv.se/countries.xml";
     qDebug() << "Starting to fetch countries (" << url << ")";
 
-    QNetworkRequest request((QUrl(url)));
-    QNetworkReply *reply = get(request);
-    connect(reply, &QNetworkReply::finished, this, [this, url, reply]() {
-        if (reply->error()) {
-            qWarning() << "Error fetching countries";
-            qWarning() << reply->errorString();
-            Q_EMIT errorFetching(Error(reply->error(), reply->errorString()));
-        } else {
-            QByteArray data = reply->readAll();
-
-            QDomDocument versionXML;
-
-            if (!versionXML.setContent(data)) {
-                qWarning() << "Failed to parse XML";
+    fetchXml(
+        url,
+        [this](XmlTvParser::Batch &batch) {
+            for (const CountryData &country : qAsConst(batch.m_countries)) {
+                processCountry(country);
             }
-
-            QDomNodeList nodes = versionXML.elementsByTagName("country");
-            for (int i = 0; i < nodes.count(); i++) {
-                QDomNode elm = nodes.at(i);
-                if (elm.isElement()) {
-                    const QDomElement &countryElement = elm.toElement();
-                    processCountry(countryElement);
-                }
+        },
+        [this](QNetworkReply *reply, const XmlTvParser &parser) {
+            Q_UNUSED(parser)
+            if (reply->error()) {
+                qWarning() << "Error fetching countries";
+                qWarning() << reply->errorString();
+                Q_EMIT errorFetching(Error(reply->error(), reply->errorString()));
             }
-        }
-        delete reply;
-    });
+        });
 }
 
 void XmlTvSeFetcher::fetchCountry(const QString &url, const CountryId &countryId)
 {
     qDebug() << "Starting to fetch country (" << countryId.value() << ", " << url << ")";
 
-    QNetworkRequest request((QUrl(url)));
-    QNetworkReply *reply = get(request);
-    connect(reply, &QNetworkReply::finished, this, [this, url, countryId, reply]() {
-        if (reply->error()) {
-            qWarning() << "Error fetching country";
-            qWarning() << reply->errorString();
-            Q_EMIT errorFetchingCountry(countryId, Error(reply->error(), reply->errorString()));
-        } else {
-            QByteArray data = reply->readAll();
-
-            QDomDocument versionXML;
-
-            if (!versionXML.setContent(data)) {
-                qWarning() << "Failed to parse XML";
+    fetchXml(
+        url,
+        [this, countryId](XmlTvParser::Batch &batch) {
+            for (const ChannelData &channel : qAsConst(batch.m_channels)) {
+                fetchChannel(channel.m_id, channel.m_name, countryId);
             }
-
-            QDomNodeList nodes = versionXML.elementsByTagName("channel");
-
-            for (int i = 0; i < nodes.count(); i++) {
-                QDomNode elm = nodes.at(i);
-                if (elm.isElement()) {
-                    const QDomNamedNodeMap &attributes = elm.attributes();
-                    const ChannelId id = ChannelId(attributes.namedItem("id").toAttr().value());
-
-                    const QString &name = elm.firstChildElement("display-name").text();
-
-                    fetchChannel(id, name, countryId);
-                }
+        },
+        [this, countryId](QNetworkReply *reply, const XmlTvParser &parser) {
+            Q_UNUSED(parser)
+            if (reply->error()) {
+                qWarning() << "Error fetching country";
+                qWarning() << reply->errorString();
+                Q_EMIT errorFetchingCountry(countryId, Error(reply->error(), reply->errorString()));
             }
-        }
-        delete reply;
-        Q_EMIT countryUpdated(countryId);
-    });
+            Q_EMIT countryUpdated(countryId);
+        });
 }
 
 void XmlTvSeFetcher::fetchProgramDescription(const ChannelId &channelId, const ProgramId &programId, const QString &url)
 {
-    Q_UNUSED(channelId)
-    Q_UNUSED(programId)
     Q_UNUSED(url)
 
-    // nothing to be done (already fetched as part of the program)
+    // already fetched as part of the program, report it (as if it had been fetched) so that the request is done
+    Q_EMIT programDescriptionUpdated(channelId, programId, Database::instance().programDescription(programId));
 }
 
 void XmlTvSeFetcher::fetchChannel(const ChannelId &channelId, const QString &name, const CountryId &countryId)
@@ -116,103 +103,161 @@ void XmlTvSeFetcher::fetchChannel(const ChannelId &channelId, const QString &nam
     }
 }
 
-void XmlTvSeFetcher::fetchProgram(const ChannelId &channelId)
+void XmlTvSeFetcher::fetchProgram(const ChannelId &channelId, const ChannelId &providerChannelId, const QVector<QDate> &days)
 {
-    const QString url = "http://xmltv.xmltv.se/" + channelId.value();
+    const QString url = "http://xmltv.xmltv.se/" + providerChannelId.value();
 
-    QDate today = QDate::currentDate();
-    QDate yesterday = QDate::currentDate().addDays(-1);
-    QDate tomorrow = QDate::currentDate().addDays(1);
-    QSet<QDate> days{yesterday, today, tomorrow};
-    for (auto day : days) {
+    QVector<QDate> missingDays;
+    for (const QDate &day : days) {
         // check if program is available already
         const QDateTime utcTime(day, QTime(), Qt::UTC);
         const qint64 lastTime = utcTime.addDays(1).toSecsSinceEpoch() - 1;
 
-        if (Database::instance().programExists(channelId, lastTime)) {
-            continue;
+        if (!Database::instance().programExists(channelId, lastTime)) {
+            missingDays.append(day);
         }
+    }
+    if (missingDays.isEmpty()) {
+        Q_EMIT programFetchFinished(channelId);
+        return;
+    }
 
+    const std::shared_ptr<int> pendingDays = std::make_shared<int>(missingDays.size());
+    for (const QDate &day : qAsConst(missingDays)) {
         const QString urlDay = url + "_" + day.toString("yyyy-MM-dd") + ".xml"; // e.g. http://xmltv.xmltv.se/3sat.de_2021-07-29.xml
         qDebug() << "Starting to fetch program for " << channelId.value() << "(" << urlDay << ")";
 
-        QNetworkRequest request((QUrl(urlDay)));
-        QNetworkReply *reply = get(request);
-        connect(reply, &QNetworkReply::finished, this, [this, channelId, reply]() {
-            if (reply->error()) {
-                qWarning() << "Error fetching channel";
-                qWarning() << reply->errorString();
-                Q_EMIT errorFetchingChannel(channelId, Error(reply->error(), reply->errorString()));
-            } else {
-                QByteArray data = reply->readAll();
+        // store programs batch by batch while the download is still running
+        fetchXml(
+            urlDay,
+            [this, channelId](XmlTvParser::Batch &batch) {
+                processPrograms(channelId, batch.m_programs);
+            },
+            [this, channelId, pendingDays](QNetworkReply *reply, const XmlTvParser &parser) {
+                if (reply->error()) {
+                    qWarning() << "Error fetching channel";
+                    qWarning() << reply->errorString();
+                    Q_EMIT errorFetchingChannel(channelId, Error(reply->error(), reply->errorString()));
+                } else if (parser.programCount() > 0) {
+                    Q_EMIT channelUpdated(channelId);
+                }
+                if (--*pendingDays == 0) {
+                    Q_EMIT programFetchFinished(channelId);
+                }
+            },
+            channelId);
+    }
+}
 
-                QDomDocument versionXML;
+// a reply which is parsed chunk by chunk on the ParserPool
+struct XmlTvSeFetcher::XmlReply {
+    QNetworkReply *m_reply = nullptr;
+    XmlTvParser m_parser; // only accessed by the running job while m_parsing
+    BatchHandler m_processBatch;
+    FinishedHandler m_finished;
+    bool m_parsing = false;
+    bool m_done = false;
+};
+
+void XmlTvSeFetcher::fetchXml(const QString &url, const BatchHandler &processBatch, const FinishedHandler &finished, const ChannelId &channelId)
+{
+    std::shared_ptr<XmlReply> xmlReply = std::make_shared<XmlReply>();
+    xmlReply->m_processBatch = processBatch;
+    xmlReply->m_finished = finished;
 
-                if (!versionXML.setContent(data)) {
-                    qWarning() << "Failed to parse XML";
-                }
+    QNetworkRequest request((QUrl(url)));
+    xmlReply->m_reply = get(request, channelId);
+    // parsing cannot keep up: stall the download instead of buffering everything
+    xmlReply->m_reply->setReadBufferSize(READ_BUFFER_SIZE);
+
+    // parse while the data is coming in instead of waiting for the complete document
+    connect(xmlReply->m_reply, &QNetworkReply::readyRead, this, [this, xmlReply]() {
+        parseXml(xmlReply);
+    });
+    connect(xmlReply->m_reply, &QNetworkReply::finished, this, [this, xmlReply]() {
+        parseXml(xmlReply);
+    });
+}
 
-                QDomElement docElem = versionXML.documentElement();
+void XmlTvSeFetcher::parseXml(const std::shared_ptr<XmlReply> &xmlReply)
+{
+    // only one chunk at a time per reply (the next one is parsed when the running job is done)
+    if (xmlReply->m_done || xmlReply->m_parsing) {
+        return;
+    }
 
-                processChannel(docElem);
+    QNetworkReply *reply = xmlReply->m_reply;
+    if (reply->error()) {
+        if (reply->isFinished()) {
+            finishXml(xmlReply);
+        }
+        return;
+    }
+
+    const QByteArray data = reply->readAll();
+    const bool last = reply->isFinished();
+    if (data.isEmpty() && !last) {
+        return;
+    }
+
+    xmlReply->m_parsing = true;
+    ParserPool::instance().submit<XmlTvParser::Batch>(
+        reply,
+        reply->url().toString(),
+        [xmlReply, data, last]() -> XmlTvParser::Batch {
+            xmlReply->m_parser.addData(data);
+            if (last) {
+                xmlReply->m_parser.finish();
+            }
+            return xmlReply->m_parser.takeBatch();
+        },
+        [this, xmlReply, last](XmlTvParser::Batch &batch) {
+            xmlReply->m_parsing = false;
+            const int rows = batch.m_countries.size() + batch.m_channels.size() + batch.m_programs.size();
+            const qint64 databaseTime = Database::instance().busyTime();
+            xmlReply->m_processBatch(batch);
+            FetchMetrics::instance().recordStored(xmlReply->m_reply, rows, Database::instance().busyTime() - databaseTime);
+            if (last) {
+                finishXml(xmlReply);
+            } else {
+                parseXml(xmlReply);
             }
-            delete reply;
         });
-    }
 }
 
-void XmlTvSeFetcher::processCountry(const QDomElement &country)
+void XmlTvSeFetcher::finishXml(const std::shared_ptr<XmlReply> &xmlReply)
 {
-    const CountryId id = CountryId(country.attributes().namedItem("id").toAttr().value());
-    const QString &name = country.text();
+    xmlReply->m_done = true;
+    xmlReply->m_finished(xmlReply->m_reply, xmlReply->m_parser);
+    xmlReply->m_reply->deleteLater();
+}
 
-    Q_EMIT startedFetchingCountry(id);
+void XmlTvSeFetcher::processCountry(const CountryData &country)
+{
+    TRACE_FUNCTION("parse");
+    Q_EMIT startedFetchingCountry(country.m_id);
 
     // http://xmltv.xmltv.se/channels-Germany.xml
-    const QString url = "http://xmltv.xmltv.se/channels-" + id.value() + ".xml";
+    const QString url = "http://xmltv.xmltv.se/channels-" + country.m_id.value() + ".xml";
 
-    Database::instance().addCountry(id, name, url);
+    Database::instance().addCountry(country.m_id, country.m_name, url);
 
-    Q_EMIT countryUpdated(id);
+    Q_EMIT countryUpdated(country.m_id);
 }
 
-void XmlTvSeFetcher::processChannel(const QDomElement &channel)
+void XmlTvSeFetcher::processPrograms(const ChannelId &channelId, QVector<ProgramData> &programs)
 {
-    QDomNodeList programs = channel.elementsByTagName("programme");
-    const QDomNamedNodeMap &attributes = programs.at(0).attributes();
+    TRACE_FUNCTION("parse");
+    if (programs.isEmpty()) {
+        return;
+    }
 
-    const ChannelId channelId = ChannelId(attributes.namedItem("channel").toAttr().value());
-    if (programs.count() > 0) {
-        for (int i = 0; i < programs.count(); i++) {
-            processProgram(programs.at(i));
+    // fetched as fallback for a channel of another provider: store the programs for that channel
+    if (programs.first().m_channelId != channelId) {
+        for (ProgramData &program : programs) {
+            program.m_id = ProgramId(channelId.value() + "_" + QString::number(program.m_startTime.toSecsSinceEpoch()));
+            program.m_channelId = channelId;
         }
-
-        Q_EMIT channelUpdated(channelId);
     }
-}
-
-void XmlTvSeFetcher::processProgram(const QDomNode &program)
-{
-    ProgramData data;
-
-    const QDomNamedNodeMap &attributes = program.attributes();
-    data.m_channelId = ChannelId(attributes.namedItem("channel").toAttr().value());
-    const QString &startTimeString = attributes.namedItem("start").toAttr().value();
-    QDateTime startTime = QDateTime::fromString(startTimeString, "yyyyMMddHHmmss +0000");
-    startTime.setTimeSpec(Qt::UTC);
-    data.m_startTime = startTime;
-    // channel + start time can be used as ID
-    data.m_id = ProgramId(data.m_channelId.value() + "_" + QString::number(startTime.toSecsSinceEpoch()));
-    const QString &stopTimeString = attributes.namedItem("stop").toAttr().value();
-    QDateTime stopTime = QDateTime::fromString(stopTimeString, "yyyyMMddHHmmss +0000");
-    stopTime.setTimeSpec(Qt::UTC);
-    data.m_stopTime = stopTime;
-    data.m_title = program.namedItem("title").toElement().text();
-    data.m_subtitle = program.namedItem("sub-title").toElement().text();
-    data.m_description = program.namedItem("desc").toElement().text();
-    data.m_category = program.namedItem("category").toElement().text();
-
-    data.m_descriptionFetched = true;
-
-    Database::instance().addProgram(data);
+    Database::instance().addPrograms(programs);
 }
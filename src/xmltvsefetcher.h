@@ -2,8 +2,14 @@
 
 #include "networkfetcher.h"
 
-class QDomElement;
-class QDomNode;
+#include "countrydata.h"
+#include "programdata.h"
+#include "xmltvparser.h"
+
+#include <QVector>
+
+#include <functional>
+#include <memory>
 
 class XmlTvSeFetcher : public NetworkFetcher
 {
@@ -12,14 +18,22 @@ public:
     XmlTvSeFetcher();
     virtual ~XmlTvSeFetcher() = default;
 
+    QString name() const override;
+    bool handlesUrl(const QUrl &url) const override;
+
     void fetchCountries() override;
     void fetchCountry(const QString &url, const CountryId &countryId) override;
-    void fetchProgram(const ChannelId &channelId) override;
+    void fetchProgram(const ChannelId &channelId, const ChannelId &providerChannelId, const QVector<QDate> &days) override;
     void fetchProgramDescription(const ChannelId &channelId, const ProgramId &programId, const QString &url) override;
 
 private:
     void fetchChannel(const ChannelId &channelId, const QString &name, const CountryId &countryId);
-    void processCountry(const QDomElement &country);
-    void processChannel(const QDomElement &channel);
-    void processProgram(const QDomNode &program);
+    using BatchHandler = std::function<void(XmlTvParser::Batch &batch)>;
+    using FinishedHandler = std::function<void(QNetworkReply *reply, const XmlTvParser &parser)>;
+    struct XmlReply;
+    void fetchXml(const QString &url, const BatchHandler &processBatch, const FinishedHandler &finished, const ChannelId &channelId = ChannelId());
+    void parseXml(const std::shared_ptr<XmlReply> &xmlReply);
+    void finishXml(const std::shared_ptr<XmlReply> &xmlReply);
+    void processCountry(const CountryData &country);
+    void processPrograms(const ChannelId &channelId, QVector<ProgramData> &programs);
 };
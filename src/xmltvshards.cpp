@@ -0,0 +1,195 @@
+#include "xmltvshards.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QThreadPool>
+
+#include <atomic>
+#include <cstring>
+
+namespace
+{
+const qint64 MIN_SHARD_SIZE = 1024 * 1024;
+const qint64 MAX_SHARD_SIZE = 16 * 1024 * 1024;
+// more shards than threads such that threads which are done early get more work
+const int SHARDS_PER_THREAD = 4;
+
+const char PROGRAMME[] = "<programme";
+const int PROGRAMME_LENGTH = sizeof(PROGRAMME) - 1;
+}
+
+XmlTvShards::XmlTvShards(const QString &path)
+    : m_file(path)
+    , m_data(nullptr)
+    , m_size(0)
+    , m_headerEnd(0)
+{
+}
+
+XmlTvShards::~XmlTvShards()
+{
+    if (m_data) {
+        m_file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(m_data)));
+    }
+}
+
+bool XmlTvShards::open(int threadCount)
+{
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    m_size = m_file.size();
+    if (m_size == 0) {
+        m_error = QStringLiteral("Empty file");
+        return false;
+    }
+    m_data = reinterpret_cast<const char *>(m_file.map(0, m_size));
+    if (!m_data) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    const char *end = m_data + m_size;
+
+    // e.g. <?xml version="1.0" encoding="UTF-8"?> (keeps the encoding for the shards)
+    m_prefix.clear();
+    if (m_size > 5 && std::memcmp(m_data, "<?xml", 5) == 0) {
+        const char *declarationEnd = static_cast<const char *>(std::memchr(m_data, '>', m_size));
+        if (declarationEnd) {
+            m_prefix = QByteArray(m_data, static_cast<int>(declarationEnd + 1 - m_data));
+        }
+    }
+    m_prefix += "<tv>";
+
+    const char *firstProgramme = findProgramme(m_data, end);
+    m_headerEnd = firstProgramme ? firstProgramme - m_data : m_size;
+
+    // split at the first <programme> after the target size
+    const qint64 programsSize = m_size - m_headerEnd;
+    const qint64 shardSize = qBound(MIN_SHARD_SIZE, programsSize / (qMax(1, threadCount) * SHARDS_PER_THREAD), MAX_SHARD_SIZE);
+    m_boundaries.clear();
+    m_boundaries.append(m_headerEnd);
+    while (m_boundaries.last() < m_size) {
+        const qint64 target = m_boundaries.last() + shardSize;
+        const char *boundary = target < m_size ? findProgramme(m_data + target, end) : nullptr;
+        m_boundaries.append(boundary ? boundary - m_data : m_size);
+    }
+    qDebug() << "Split" << m_file.fileName() << "(" << m_size << "bytes) into" << count() << "shards";
+    return true;
+}
+
+QString XmlTvShards::errorString() const
+{
+    return m_error;
+}
+
+qint64 XmlTvShards::size() const
+{
+    return m_size;
+}
+
+int XmlTvShards::count() const
+{
+    return qMax(0, m_boundaries.size() - 1);
+}
+
+qint64 XmlTvShards::end(int shard) const
+{
+    return m_boundaries.at(shard + 1);
+}
+
+XmlTvParser::Batch XmlTvShards::parseHeader(QString *error) const
+{
+    // skip the XML declaration (part of the prefix) and the original root element (can contain attributes)
+    const char *rootEnd = nullptr;
+    for (const char *position = m_data; position < m_data + m_headerEnd; ++position) {
+        position = static_cast<const char *>(std::memchr(position, '<', m_data + m_headerEnd - position));
+        if (!position) {
+            break;
+        }
+        if (m_data + m_headerEnd - position > 3 && std::memcmp(position, "<tv", 3) == 0 && (position[3] == '>' || position[3] == ' ')) {
+            rootEnd = static_cast<const char *>(std::memchr(position, '>', m_data + m_headerEnd - position));
+            break;
+        }
+    }
+    const qint64 begin = rootEnd ? rootEnd + 1 - m_data : m_headerEnd;
+    // without programs, the header contains the original closing root element
+    return parse(begin, m_headerEnd, m_headerEnd < m_size, error);
+}
+
+XmlTvParser::Batch XmlTvShards::parse(int shard, QString *error) const
+{
+    // the last shard contains the original closing root element
+    return parse(m_boundaries.at(shard), m_boundaries.at(shard + 1), shard != count() - 1, error);
+}
+
+XmlTvParser::Batch XmlTvShards::parse(qint64 begin, qint64 end, bool closeDocument, QString *error) const
+{
+    XmlTvParser parser;
+    parser.addData(m_prefix);
+    // no copy of the mapped data (shards are small enough for a QByteArray)
+    parser.addData(QByteArray::fromRawData(m_data + begin, static_cast<int>(end - begin)));
+    if (closeDocument) {
+        parser.addData(QByteArrayLiteral("</tv>"));
+    }
+    parser.finish();
+
+    if (parser.hasError() && error) {
+        *error = parser.errorString();
+    }
+    return parser.takeBatch();
+}
+
+const char *XmlTvShards::findProgramme(const char *begin, const char *end) const
+{
+    for (const char *position = begin; end - position > PROGRAMME_LENGTH;) {
+        position = static_cast<const char *>(std::memchr(position, '<', end - position - PROGRAMME_LENGTH));
+        if (!position) {
+            return nullptr;
+        }
+        // "<programme " or "<programme>" (not e.g. "<programmes")
+        const char next = position[PROGRAMME_LENGTH];
+        if (std::memcmp(position, PROGRAMME, PROGRAMME_LENGTH) == 0 && (next == ' ' || next == '>' || next == '\n' || next == '\t' || next == '\r')) {
+            return position;
+        }
+        ++position;
+    }
+    return nullptr;
+}
+
+void XmlTvShards::benchmark(const QString &path)
+{
+    const int maxThreadCount = QThread::idealThreadCount();
+    qint64 singleThreadTime = 0;
+
+    for (int threadCount = 1; threadCount <= maxThreadCount; ++threadCount) {
+        QElapsedTimer timer;
+        timer.start();
+
+        XmlTvShards shards(path);
+        if (!shards.open(threadCount)) {
+            qWarning() << "Cannot open" << path << ":" << shards.errorString();
+            return;
+        }
+
+        std::atomic<qint64> programCount{0};
+        programCount += shards.parseHeader().m_programs.size();
+
+        QThreadPool threadPool;
+        threadPool.setMaxThreadCount(threadCount);
+        for (int shard = 0; shard < shards.count(); ++shard) {
+            threadPool.start([&shards, &programCount, shard]() {
+                programCount += shards.parse(shard).m_programs.size();
+            });
+        }
+        threadPool.waitForDone();
+
+        const qint64 elapsed = qMax(timer.elapsed(), Q_INT64_C(1));
+        if (threadCount == 1) {
+            singleThreadTime = elapsed;
+        }
+        qInfo().nospace() << threadCount << " threads: " << programCount.load() << " programs in " << elapsed << " ms (" << (shards.size() / 1000.0 / elapsed)
+                          << " MB/s, speedup " << (static_cast<double>(singleThreadTime) / elapsed) << ")";
+    }
+}
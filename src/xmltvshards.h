@@ -0,0 +1,43 @@
+#pragma once
+
+#include "xmltvparser.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+// splits an (uncompressed) XMLTV file at <programme> boundaries into shards which can be parsed independently
+// the file is memory mapped, i.e. it is neither copied nor read sequentially
+// after open(), all const methods may be used from several threads at once
+class XmlTvShards
+{
+public:
+    explicit XmlTvShards(const QString &path);
+    ~XmlTvShards();
+
+    bool open(int threadCount); // shards are sized such that all threads get some work
+    QString errorString() const;
+
+    qint64 size() const;
+    int count() const;
+    qint64 end(int shard) const; // offset in the file (e.g. for progress)
+
+    XmlTvParser::Batch parseHeader(QString *error = nullptr) const; // everything before the first program (channels)
+    XmlTvParser::Batch parse(int shard, QString *error = nullptr) const;
+
+    // prints the time to parse the file with 1 to N threads
+    static void benchmark(const QString &path);
+
+private:
+    XmlTvParser::Batch parse(qint64 begin, qint64 end, bool closeDocument, QString *error) const;
+    const char *findProgramme(const char *begin, const char *end) const;
+
+    QFile m_file;
+    const char *m_data;
+    qint64 m_size;
+    QString m_error;
+    QByteArray m_prefix; // XML declaration + root element (every shard must be a complete document)
+    qint64 m_headerEnd;
+    QVector<qint64> m_boundaries; // shard i is [m_boundaries[i], m_boundaries[i + 1])
+};